@@ -29,6 +29,7 @@
 #include <AMReX_AmrLevel.H>
 #include <AMReX_PROB_AMR_F.H>
 #include <AMReX_Amr.H>
+#include <AMReX_AmrDiagnostics.H>
 #include <AMReX_ParallelDescriptor.H>
 #include <AMReX_Utility.H>
 #include <AMReX_DistributionMapping.H>
@@ -178,6 +179,12 @@ Amr::getAmrLevels ()
     return amr_level;
 }
 
+AmrDiagnostics&
+Amr::getDiagnostics ()
+{
+    return *diagnostics;
+}
+
 long
 Amr::cellCount (int lev)
 {
@@ -297,6 +304,8 @@ Amr::InitAmr ()
         setRecordDataInfo(i,datalogname[i]);
     }
 
+    diagnostics.reset(new AmrDiagnostics());
+
     probin_file = "probin";  // Make "probin" the default
 
     if (pp.contains("probin_file"))
@@ -2037,6 +2046,8 @@ Amr::coarseTimeStep (Real stop_time)
 
     amr_level[0]->postCoarseTimeStep(cumtime);
 
+    diagnostics->compute(*this, level_steps[0], cumtime, dt_level[0]);
+
     if (verbose > 0)
     {
         const int IOProc   = ParallelDescriptor::IOProcessorNumber();
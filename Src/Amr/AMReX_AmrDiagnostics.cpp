@@ -0,0 +1,978 @@
+
+#include <cmath>
+#include <map>
+#include <deque>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <AMReX_AmrDiagnostics.H>
+#include <AMReX_Amr.H>
+#include <AMReX_AmrMesh.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Utility.H>
+#include <AMReX_ParallelDescriptor.H>
+
+#ifdef BL_LAZY
+#include <AMReX_Lazy.H>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace amrex {
+
+namespace
+{
+    //
+    // Writes the diagnostics files on the IOProcessor in the order they
+    // were queued, from one thread that runs as long as there is output.
+    // A failed write is reported by the next push() or flush().
+    //
+    class DiagWriter
+    {
+    public:
+
+        static DiagWriter& get ()
+        {
+            static DiagWriter* writer = nullptr;
+            if (writer == nullptr)
+            {
+                writer = new DiagWriter;
+                amrex::ExecOnFinalize(DiagWriter::Finalize);
+            }
+            return *writer;
+        }
+
+        static void Finalize ()
+        {
+            get().flush();
+        }
+
+        void push (std::function<void()>&& f)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            checkFailed(lock);
+            //
+            // Don't let a slow file system pile up more than max_queue_size outputs.
+            //
+            const std::size_t max_queue_size = 64;
+            m_done_cv.wait(lock, [this] { return m_queue.size() < max_queue_size; });
+            m_queue.push_back(std::move(f));
+            if (!m_running)
+            {
+                if (m_thread.joinable())
+                    m_thread.join();
+                m_running = true;
+                m_thread  = std::thread(&DiagWriter::run, this);
+            }
+        }
+
+        void flush ()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done_cv.wait(lock, [this] { return !m_running; });
+            if (m_thread.joinable())
+                m_thread.join();
+            checkFailed(lock);
+        }
+
+        // Called from the writer thread.
+        void fail (const std::string& file)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_failed.empty())
+                m_failed = file;
+        }
+
+    private:
+
+        DiagWriter () = default;
+
+        void run ()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_queue.empty())
+            {
+                std::function<void()> f = std::move(m_queue.front());
+                m_queue.pop_front();
+                lock.unlock();
+                f();
+                lock.lock();
+                m_done_cv.notify_all();
+            }
+            //
+            // The thread exits when the queue is empty, so nothing is left
+            // running between outputs or at exit.
+            //
+            m_running = false;
+            m_done_cv.notify_all();
+        }
+
+        void checkFailed (std::unique_lock<std::mutex>& lock)
+        {
+            if (!m_failed.empty())
+            {
+                const std::string file = m_failed;
+                lock.unlock();
+                amrex::FileOpenFailed(file);
+            }
+        }
+
+        std::thread                        m_thread;
+        std::mutex                         m_mutex;
+        std::condition_variable            m_done_cv;
+        std::deque<std::function<void()> > m_queue;
+        bool                               m_running = false;
+        std::string                        m_failed;
+    };
+
+    // Refinement ratio between lev and the finest level.
+    IntVect
+    cumulativeRatio (const AmrMesh& mesh, int lev)
+    {
+        IntVect ratio(IntVect::TheUnitVector());
+        for (int l = lev; l < mesh.finestLevel(); ++l)
+            ratio *= mesh.refRatio(l);
+        return ratio;
+    }
+
+    // The bounds of bx, with the directions beyond AMREX_SPACEDIM set to 0.
+    void
+    loopBounds (const Box& bx, int lo[3], int hi[3])
+    {
+        for (int d = 0; d < 3; ++d)
+        {
+            lo[d] = (d < AMREX_SPACEDIM) ? bx.smallEnd(d) : 0;
+            hi[d] = (d < AMREX_SPACEDIM) ? bx.bigEnd(d)   : 0;
+        }
+    }
+
+    // Offset of cell (i,j,k) in the data of a FAB on fbx.
+    struct FabIndexer
+    {
+        explicit FabIndexer (const Box& fbx)
+        {
+            long stride = 1;
+            for (int d = 0; d < 3; ++d)
+            {
+                lo[d]  = (d < AMREX_SPACEDIM) ? fbx.smallEnd(d) : 0;
+                str[d] = (d < AMREX_SPACEDIM) ? stride : 0;
+                if (d < AMREX_SPACEDIM)
+                    stride *= fbx.length(d);
+            }
+        }
+
+        long operator() (int i, int j, int k) const
+        {
+            return (i-lo[0])*str[0] + (j-lo[1])*str[1] + (k-lo[2])*str[2];
+        }
+
+        int  lo[3];
+        long str[3];
+    };
+
+    // Index of the cell containing coordinate x in direction dir.
+    int
+    cellIndex (const Geometry& geom, Real x, int dir)
+    {
+        return geom.Domain().smallEnd(dir)
+            + static_cast<int>(std::floor((x - geom.ProbLo(dir)) * geom.InvCellSize(dir)));
+    }
+
+    // Clamped to the domain.
+    int
+    cellIndexInDomain (const Geometry& geom, Real x, int dir)
+    {
+        const Box& domain = geom.Domain();
+        return std::min(std::max(cellIndex(geom, x, dir), domain.smallEnd(dir)), domain.bigEnd(dir));
+    }
+
+    // Writes a block of n rows "x v0 v1 ..." from nvar weighted sums followed by the weights.
+    std::function<void(std::ofstream&, const Vector<Real>&)>
+    profileWriter (int step, Real time, int n, Real lo, Real dx, const Vector<std::string>& vars)
+    {
+        return [=] (std::ofstream& ofs, const Vector<Real>& sum)
+        {
+            const int nvar = vars.size();
+            ofs << "# step " << step << " time " << time << " n " << n << " vars";
+            for (const auto& v : vars)
+                ofs << ' ' << v;
+            ofs << '\n';
+            for (int i = 0; i < n; ++i)
+            {
+                const Real w = sum[nvar*n+i];
+                ofs << lo + (i+0.5)*dx;
+                for (int v = 0; v < nvar; ++v)
+                    ofs << ' ' << ((w > 0.0) ? sum[v*n+i]/w : 0.0);
+                ofs << '\n';
+            }
+        };
+    }
+}
+
+bool AmrReduction::async_output = true;
+
+AmrReduction::AmrReduction (const std::string& name, const std::string& dir)
+    :
+    m_name(name),
+    m_file(dir + "/" + name),
+    m_int(-1),
+    m_per(-1.0),
+    m_first(true)
+{
+    ParmParse pp("amr.diag." + name);
+
+    const int nvars = pp.countval("vars");
+    if (nvars == 0)
+        amrex::Abort("AmrReduction: amr.diag." + name + ".vars not given");
+    pp.getarr("vars", m_vars, 0, nvars);
+
+    pp.query("int", m_int);
+    pp.query("per", m_per);
+    if (m_int <= 0 && m_per <= 0.0)
+        m_int = 1;
+}
+
+bool
+AmrReduction::doNow (int step, Real time, Real dt) const
+{
+    int per_test = 0;
+    if (m_per > 0.0)
+    {
+        const int num_per_old = (time-dt) / m_per;
+        const int num_per_new = (time   ) / m_per;
+
+        if (num_per_old != num_per_new)
+            per_test = 1;
+    }
+
+    return (m_int > 0 && step % m_int == 0) || per_test == 1;
+}
+
+void
+AmrReduction::reduceAndWrite (Vector<Real>&& buf, const std::string& file,
+                              std::function<void(std::ofstream&, const Vector<Real>&)>&& write,
+                              bool append)
+{
+    const int IOProc = ParallelDescriptor::IOProcessorNumber();
+
+#ifdef BL_LAZY
+    Lazy::QueueReduction( [=] () mutable {
+#endif
+    ParallelDescriptor::ReduceRealSum(buf.dataPtr(), buf.size(), IOProc);
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        const bool async = async_output;
+        auto data = std::make_shared<Vector<Real> >(std::move(buf));
+        auto job = [data, file, write, append, async] ()
+        {
+            std::ofstream ofs(file.c_str(), append ? (std::ios::out|std::ios::app|std::ios::binary)
+                                                   : (std::ios::out|std::ios::trunc|std::ios::binary));
+            if (!ofs.good())
+            {
+                if (async)
+                    DiagWriter::get().fail(file);
+                else
+                    amrex::FileOpenFailed(file);
+                return;
+            }
+            ofs.precision(15);
+            write(ofs, *data);
+        };
+
+        if (async)
+            DiagWriter::get().push(std::move(job));
+        else
+            job();
+    }
+#ifdef BL_LAZY
+    });
+#endif
+}
+
+PlaneAverageReduction::PlaneAverageReduction (const std::string& name, const std::string& dir)
+    :
+    AmrReduction(name, dir),
+    m_dir(AMREX_SPACEDIM-1)
+{
+    ParmParse pp("amr.diag." + name);
+    pp.query("dir", m_dir);
+    BL_ASSERT(m_dir >= 0 && m_dir < AMREX_SPACEDIM);
+}
+
+void
+PlaneAverageReduction::compute (const AmrMesh& mesh,
+                                const Vector<Vector<const MultiFab*> >& data,
+                                const Vector<const iMultiFab*>& mask,
+                                int step, Real time)
+{
+    BL_PROFILE("PlaneAverageReduction::compute()");
+
+    const int finest_level = mesh.finestLevel();
+    const Geometry& fgeom  = mesh.Geom(finest_level);
+    const Box& fdomain     = fgeom.Domain();
+    const int nvar         = m_vars.size();
+    const int n            = fdomain.length(m_dir);
+    const int off          = fdomain.smallEnd(m_dir);
+    //
+    // The area weighted sums of each variable followed by the areas.
+    //
+    Vector<Real> sum((nvar+1)*n, 0.0);
+
+    for (int lev = 0; lev <= finest_level; ++lev)
+    {
+        const int ratio = cumulativeRatio(mesh, lev)[m_dir];
+        const Real* dx  = mesh.Geom(lev).CellSize();
+
+        Real area = 1.0;
+        for (int d = 0; d < AMREX_SPACEDIM; ++d)
+            if (d != m_dir) area *= dx[d];
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            Vector<Real> priv((nvar+1)*n, 0.0);
+            Vector<const Real*> dp(nvar);
+            Vector<FabIndexer>  di;
+
+            for (MFIter mfi(*mask[lev], true); mfi.isValid(); ++mfi)
+            {
+                const IArrayBox& m = (*mask[lev])[mfi];
+                const int* mp      = m.dataPtr();
+                const FabIndexer mi(m.box());
+
+                di.clear();
+                for (int v = 0; v < nvar; ++v)
+                {
+                    const FArrayBox& fab = (*data[lev][v])[mfi];
+                    dp[v] = fab.dataPtr();
+                    di.push_back(FabIndexer(fab.box()));
+                }
+
+                int lo[3], hi[3];
+                loopBounds(mfi.tilebox(), lo, hi);
+
+                for (int k = lo[2]; k <= hi[2]; ++k)
+                for (int j = lo[1]; j <= hi[1]; ++j)
+                for (int i = lo[0]; i <= hi[0]; ++i)
+                {
+                    if (mp[mi(i,j,k)] == 0) continue;
+
+                    const int ijk[3] = {i, j, k};
+                    const int i0 = ijk[m_dir]*ratio - off;
+                    for (int v = 0; v < nvar; ++v)
+                    {
+                        const Real val = dp[v][di[v](i,j,k)] * area;
+                        for (int r = 0; r < ratio; ++r)
+                            priv[v*n+i0+r] += val;
+                    }
+                    for (int r = 0; r < ratio; ++r)
+                        priv[nvar*n+i0+r] += area;
+                }
+            }
+#ifdef _OPENMP
+#pragma omp critical(amr_diag_sum)
+#endif
+            for (int i = 0; i < (nvar+1)*n; ++i)
+                sum[i] += priv[i];
+        }
+    }
+
+    reduceAndWrite(std::move(sum), m_file + ".dat",
+                   profileWriter(step, time, n, fgeom.ProbLo(m_dir), fgeom.CellSize(m_dir), m_vars));
+    m_first = false;
+}
+
+LineReduction::LineReduction (const std::string& name, const std::string& dir)
+    :
+    AmrReduction(name, dir),
+    m_dir(0),
+    m_point(AMREX_SPACEDIM, 0.0)
+{
+    ParmParse pp("amr.diag." + name);
+    pp.query("dir", m_dir);
+    BL_ASSERT(m_dir >= 0 && m_dir < AMREX_SPACEDIM);
+    pp.getarr("point", m_point, 0, AMREX_SPACEDIM);
+}
+
+void
+LineReduction::compute (const AmrMesh& mesh,
+                        const Vector<Vector<const MultiFab*> >& data,
+                        const Vector<const iMultiFab*>& mask,
+                        int step, Real time)
+{
+    BL_PROFILE("LineReduction::compute()");
+
+    const int finest_level = mesh.finestLevel();
+    const Geometry& fgeom  = mesh.Geom(finest_level);
+    const Box& fdomain     = fgeom.Domain();
+    const int nvar         = m_vars.size();
+    const int n            = fdomain.length(m_dir);
+    const int off          = fdomain.smallEnd(m_dir);
+    //
+    // The sums of each variable followed by the number of samples.
+    // With the masks each point of the line is sampled exactly once.
+    //
+    Vector<Real> sum((nvar+1)*n, 0.0);
+
+    for (int lev = 0; lev <= finest_level; ++lev)
+    {
+        const int ratio = cumulativeRatio(mesh, lev)[m_dir];
+
+        Box line(mesh.Geom(lev).Domain());
+        for (int d = 0; d < AMREX_SPACEDIM; ++d)
+        {
+            if (d != m_dir)
+            {
+                const int i = cellIndexInDomain(mesh.Geom(lev), m_point[d], d);
+                line.setSmall(d, i);
+                line.setBig(d, i);
+            }
+        }
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            Vector<Real> priv((nvar+1)*n, 0.0);
+            Vector<const Real*> dp(nvar);
+            Vector<FabIndexer>  di;
+
+            for (MFIter mfi(*mask[lev], true); mfi.isValid(); ++mfi)
+            {
+                const Box bx = mfi.tilebox() & line;
+                if (!bx.ok()) continue;
+
+                const IArrayBox& m = (*mask[lev])[mfi];
+                const int* mp      = m.dataPtr();
+                const FabIndexer mi(m.box());
+
+                di.clear();
+                for (int v = 0; v < nvar; ++v)
+                {
+                    const FArrayBox& fab = (*data[lev][v])[mfi];
+                    dp[v] = fab.dataPtr();
+                    di.push_back(FabIndexer(fab.box()));
+                }
+
+                int lo[3], hi[3];
+                loopBounds(bx, lo, hi);
+
+                for (int k = lo[2]; k <= hi[2]; ++k)
+                for (int j = lo[1]; j <= hi[1]; ++j)
+                for (int i = lo[0]; i <= hi[0]; ++i)
+                {
+                    if (mp[mi(i,j,k)] == 0) continue;
+
+                    const int ijk[3] = {i, j, k};
+                    const int i0 = ijk[m_dir]*ratio - off;
+                    for (int v = 0; v < nvar; ++v)
+                    {
+                        const Real val = dp[v][di[v](i,j,k)];
+                        for (int r = 0; r < ratio; ++r)
+                            priv[v*n+i0+r] += val;
+                    }
+                    for (int r = 0; r < ratio; ++r)
+                        priv[nvar*n+i0+r] += 1.0;
+                }
+            }
+#ifdef _OPENMP
+#pragma omp critical(amr_diag_sum)
+#endif
+            for (int i = 0; i < (nvar+1)*n; ++i)
+                sum[i] += priv[i];
+        }
+    }
+
+    reduceAndWrite(std::move(sum), m_file + ".dat",
+                   profileWriter(step, time, n, fgeom.ProbLo(m_dir), fgeom.CellSize(m_dir), m_vars));
+    m_first = false;
+}
+
+SliceReduction::SliceReduction (const std::string& name, const std::string& dir)
+    :
+    AmrReduction(name, dir),
+    m_dir(AMREX_SPACEDIM-1),
+    m_coord(0.0)
+{
+    ParmParse pp("amr.diag." + name);
+    pp.query("dir", m_dir);
+    BL_ASSERT(m_dir >= 0 && m_dir < AMREX_SPACEDIM);
+    pp.get("coord", m_coord);
+}
+
+void
+SliceReduction::compute (const AmrMesh& mesh,
+                         const Vector<Vector<const MultiFab*> >& data,
+                         const Vector<const iMultiFab*>& mask,
+                         int step, Real time)
+{
+    BL_PROFILE("SliceReduction::compute()");
+
+    const int finest_level = mesh.finestLevel();
+    const Geometry& fgeom  = mesh.Geom(finest_level);
+    const int nvar         = m_vars.size();
+
+    Box slice(fgeom.Domain());
+    const int kf = cellIndexInDomain(fgeom, m_coord, m_dir);
+    slice.setSmall(m_dir, kf);
+    slice.setBig(m_dir, kf);
+
+    FArrayBox fab(slice, nvar);
+    fab.setVal(0.0);
+
+    Real* sp         = fab.dataPtr();
+    const long ncell = slice.numPts();
+    const FabIndexer si(slice);
+
+    for (int lev = 0; lev <= finest_level; ++lev)
+    {
+        const IntVect ratio = cumulativeRatio(mesh, lev);
+        const Box cslice    = amrex::coarsen(slice, ratio);
+        //
+        // Each unmasked cell fills its own part of the slice, so the
+        // threads write to disjoint parts of fab.
+        //
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            Vector<const Real*> dp(nvar);
+            Vector<FabIndexer>  di;
+
+            for (MFIter mfi(*mask[lev], true); mfi.isValid(); ++mfi)
+            {
+                const Box bx = mfi.tilebox() & cslice;
+                if (!bx.ok()) continue;
+
+                const IArrayBox& m = (*mask[lev])[mfi];
+                const int* mp      = m.dataPtr();
+                const FabIndexer mi(m.box());
+
+                di.clear();
+                for (int v = 0; v < nvar; ++v)
+                {
+                    const FArrayBox& f = (*data[lev][v])[mfi];
+                    dp[v] = f.dataPtr();
+                    di.push_back(FabIndexer(f.box()));
+                }
+
+                int lo[3], hi[3];
+                loopBounds(bx, lo, hi);
+
+                for (int k = lo[2]; k <= hi[2]; ++k)
+                for (int j = lo[1]; j <= hi[1]; ++j)
+                for (int i = lo[0]; i <= hi[0]; ++i)
+                {
+                    if (mp[mi(i,j,k)] == 0) continue;
+
+                    const IntVect iv(AMREX_D_DECL(i,j,k));
+                    int flo[3], fhi[3];
+                    loopBounds(amrex::refine(Box(iv,iv), ratio) & slice, flo, fhi);
+
+                    for (int v = 0; v < nvar; ++v)
+                    {
+                        const Real val = dp[v][di[v](i,j,k)];
+                        Real* s = sp + v*ncell;
+                        for (int kk = flo[2]; kk <= fhi[2]; ++kk)
+                        for (int jj = flo[1]; jj <= fhi[1]; ++jj)
+                        for (int ii = flo[0]; ii <= fhi[0]; ++ii)
+                            s[si(ii,jj,kk)] = val;
+                    }
+                }
+            }
+        }
+    }
+
+    Vector<Real> buf(fab.dataPtr(), fab.dataPtr() + slice.numPts()*nvar);
+
+    reduceAndWrite(std::move(buf), amrex::Concatenate(m_file + "_", step, 5) + ".fab",
+                   [=] (std::ofstream& ofs, const Vector<Real>& s)
+                   {
+                       FArrayBox out(slice, nvar);
+                       std::copy(s.begin(), s.end(), out.dataPtr());
+                       out.writeOn(ofs);
+                   },
+                   false);
+    m_first = false;
+}
+
+HistogramReduction::HistogramReduction (const std::string& name, const std::string& dir)
+    :
+    AmrReduction(name, dir),
+    m_nbins(100),
+    m_min(0.0),
+    m_max(1.0)
+{
+    ParmParse pp("amr.diag." + name);
+    pp.query("nbins", m_nbins);
+    pp.get("min", m_min);
+    pp.get("max", m_max);
+
+    if (m_vars.size() != 1)
+        amrex::Abort("HistogramReduction: amr.diag." + name + ".vars must name one variable");
+    if (m_nbins <= 0 || m_max <= m_min)
+        amrex::Abort("HistogramReduction: bad nbins, min or max for amr.diag." + name);
+}
+
+void
+HistogramReduction::compute (const AmrMesh& mesh,
+                             const Vector<Vector<const MultiFab*> >& data,
+                             const Vector<const iMultiFab*>& mask,
+                             int step, Real time)
+{
+    BL_PROFILE("HistogramReduction::compute()");
+
+    const int finest_level = mesh.finestLevel();
+    const Real binv        = m_nbins / (m_max - m_min);
+    //
+    // The volume in each bin followed by the total volume.
+    //
+    Vector<Real> bins(m_nbins+1, 0.0);
+
+    for (int lev = 0; lev <= finest_level; ++lev)
+    {
+        const Real* dx = mesh.Geom(lev).CellSize();
+        const Real vol = AMREX_D_TERM(dx[0],*dx[1],*dx[2]);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            Vector<Real> priv(m_nbins+1, 0.0);
+
+            for (MFIter mfi(*mask[lev], true); mfi.isValid(); ++mfi)
+            {
+                const IArrayBox& m  = (*mask[lev])[mfi];
+                const FArrayBox& fb = (*data[lev][0])[mfi];
+                const int*  mp      = m.dataPtr();
+                const Real* dp      = fb.dataPtr();
+                const FabIndexer mi(m.box());
+                const FabIndexer di(fb.box());
+
+                int lo[3], hi[3];
+                loopBounds(mfi.tilebox(), lo, hi);
+
+                for (int k = lo[2]; k <= hi[2]; ++k)
+                for (int j = lo[1]; j <= hi[1]; ++j)
+                for (int i = lo[0]; i <= hi[0]; ++i)
+                {
+                    if (mp[mi(i,j,k)] == 0) continue;
+
+                    const Real val = dp[di(i,j,k)];
+                    if (val >= m_min && val < m_max)
+                        priv[std::min(static_cast<int>((val - m_min) * binv), m_nbins-1)] += vol;
+                    priv[m_nbins] += vol;
+                }
+            }
+#ifdef _OPENMP
+#pragma omp critical(amr_diag_sum)
+#endif
+            for (int i = 0; i <= m_nbins; ++i)
+                bins[i] += priv[i];
+        }
+    }
+
+    const bool header = m_first;
+    const int nbins   = m_nbins;
+    const Real lo     = m_min;
+    const Real hi     = m_max;
+    const std::string var = m_vars[0];
+
+    reduceAndWrite(std::move(bins), m_file + ".dat",
+                   [=] (std::ofstream& ofs, const Vector<Real>& b)
+                   {
+                       if (header)
+                           ofs << "# step time, volume fractions of " << var
+                               << " in " << nbins << " bins over [" << lo << "," << hi << ")\n";
+                       ofs << step << ' ' << time;
+                       for (int i = 0; i < nbins; ++i)
+                           ofs << ' ' << ((b[nbins] > 0.0) ? b[i]/b[nbins] : 0.0);
+                       ofs << '\n';
+                   });
+    m_first = false;
+}
+
+ProbeReduction::ProbeReduction (const std::string& name, const std::string& dir)
+    :
+    AmrReduction(name, dir)
+{
+    ParmParse pp("amr.diag." + name);
+    const int n = pp.countval("points");
+    if (n == 0 || n % AMREX_SPACEDIM != 0)
+        amrex::Abort("ProbeReduction: amr.diag." + name + ".points needs AMREX_SPACEDIM values per point");
+    pp.getarr("points", m_points, 0, n);
+}
+
+void
+ProbeReduction::compute (const AmrMesh& mesh,
+                         const Vector<Vector<const MultiFab*> >& data,
+                         const Vector<const iMultiFab*>& mask,
+                         int step, Real time)
+{
+    BL_PROFILE("ProbeReduction::compute()");
+
+    const int finest_level = mesh.finestLevel();
+    const int nvar         = m_vars.size();
+    const int npts         = m_points.size() / AMREX_SPACEDIM;
+    //
+    // Only the finest level covering a point has it unmasked.
+    //
+    Vector<Real> vals(npts*nvar, 0.0);
+
+    for (int lev = 0; lev <= finest_level; ++lev)
+    {
+        const Geometry& geom = mesh.Geom(lev);
+
+        for (MFIter mfi(*mask[lev]); mfi.isValid(); ++mfi)
+        {
+            const Box& bx      = mfi.validbox();
+            const IArrayBox& m = (*mask[lev])[mfi];
+
+            for (int p = 0; p < npts; ++p)
+            {
+                IntVect iv;
+                for (int d = 0; d < AMREX_SPACEDIM; ++d)
+                    iv[d] = cellIndex(geom, m_points[p*AMREX_SPACEDIM+d], d);
+
+                if (!bx.contains(iv) || m(iv) == 0) continue;
+
+                for (int v = 0; v < nvar; ++v)
+                    vals[p*nvar+v] = (*data[lev][v])[mfi](iv);
+            }
+        }
+    }
+
+    const bool header               = m_first;
+    const Vector<std::string> vars  = m_vars;
+    const Vector<Real> points       = m_points;
+
+    reduceAndWrite(std::move(vals), m_file + ".dat",
+                   [=] (std::ofstream& ofs, const Vector<Real>& s)
+                   {
+                       if (header)
+                       {
+                           ofs << "# step time";
+                           for (int p = 0; p < npts; ++p)
+                           {
+                               for (int v = 0; v < nvar; ++v)
+                               {
+                                   ofs << ' ' << vars[v] << '(';
+                                   for (int d = 0; d < AMREX_SPACEDIM; ++d)
+                                       ofs << (d > 0 ? "," : "") << points[p*AMREX_SPACEDIM+d];
+                                   ofs << ')';
+                               }
+                           }
+                           ofs << '\n';
+                       }
+                       ofs << step << ' ' << time;
+                       for (int i = 0; i < npts*nvar; ++i)
+                           ofs << ' ' << s[i];
+                       ofs << '\n';
+                   });
+    m_first = false;
+}
+
+AmrDiagnostics::AmrDiagnostics ()
+    :
+    m_dir("diags"),
+    m_dir_created(false)
+{
+    ParmParse pp("amr");
+    pp.query("diag_dir", m_dir);
+
+    int async = AmrReduction::async_output;
+    pp.query("diag_async", async);
+    if (!async)
+        flush();  // so that the files are still written in order
+    AmrReduction::async_output = async;
+
+    const int n = pp.countval("diagnostics");
+    for (int i = 0; i < n; ++i)
+    {
+        std::string name;
+        pp.get("diagnostics", name, i);
+
+        std::string type;
+        ParmParse ppd("amr.diag." + name);
+        ppd.get("type", type);
+
+        if (type == "plane_average")
+            add(std::unique_ptr<AmrReduction>(new PlaneAverageReduction(name, m_dir)));
+        else if (type == "line")
+            add(std::unique_ptr<AmrReduction>(new LineReduction(name, m_dir)));
+        else if (type == "slice")
+            add(std::unique_ptr<AmrReduction>(new SliceReduction(name, m_dir)));
+        else if (type == "histogram")
+            add(std::unique_ptr<AmrReduction>(new HistogramReduction(name, m_dir)));
+        else if (type == "probe")
+            add(std::unique_ptr<AmrReduction>(new ProbeReduction(name, m_dir)));
+        else
+            amrex::Abort("AmrDiagnostics: unknown type " + type + " for amr.diag." + name);
+    }
+}
+
+AmrDiagnostics::~AmrDiagnostics ()
+{
+    flush();
+}
+
+void
+AmrDiagnostics::add (std::unique_ptr<AmrReduction>&& r)
+{
+    m_reductions.push_back(std::move(r));
+}
+
+void
+AmrDiagnostics::createDirectory ()
+{
+    if (!m_dir_created)
+    {
+        if (ParallelDescriptor::IOProcessor())
+            if (!amrex::UtilCreateDirectory(m_dir, 0755))
+                amrex::CreateDirectoryFailed(m_dir);
+        ParallelDescriptor::Barrier("AmrDiagnostics::createDirectory");
+        m_dir_created = true;
+    }
+}
+
+Vector<AmrReduction*>
+AmrDiagnostics::dueReductions (int step, Real time, Real dt) const
+{
+    Vector<AmrReduction*> due;
+    for (auto& r : m_reductions)
+        if (r->doNow(step, time, dt))
+            due.push_back(r.get());
+    return due;
+}
+
+void
+AmrDiagnostics::compute (Amr& amr, int step, Real time, Real dt)
+{
+    const Vector<AmrReduction*> due = dueReductions(step, time, dt);
+
+    if (due.empty()) return;
+
+    BL_PROFILE("AmrDiagnostics::compute()");
+
+    const int finest_level = amr.finestLevel();
+    //
+    // Derive each variable once, however many reductions use it.
+    //
+    std::map<std::string, Vector<std::unique_ptr<MultiFab> > > derived;
+    std::map<std::string, Vector<const MultiFab*> > vars;
+
+    for (AmrReduction* r : due)
+    {
+        for (const auto& name : r->vars())
+        {
+            if (derived.count(name) == 0)
+            {
+                Vector<std::unique_ptr<MultiFab> >& mfs = derived[name];
+                Vector<const MultiFab*>& mfp = vars[name];
+                mfs.resize(finest_level+1);
+                mfp.resize(finest_level+1);
+                for (int lev = 0; lev <= finest_level; ++lev)
+                {
+                    mfs[lev] = amr.derive(name, time, lev, 0);
+                    mfp[lev] = mfs[lev].get();
+                }
+            }
+        }
+    }
+
+    run(amr, due, vars, step, time);
+}
+
+void
+AmrDiagnostics::compute (const AmrMesh& mesh,
+                         const std::map<std::string, Vector<const MultiFab*> >& vars,
+                         int step, Real time, Real dt)
+{
+    const Vector<AmrReduction*> due = dueReductions(step, time, dt);
+
+    if (due.empty()) return;
+
+    BL_PROFILE("AmrDiagnostics::compute()");
+
+    run(mesh, due, vars, step, time);
+}
+
+void
+AmrDiagnostics::run (const AmrMesh& mesh, const Vector<AmrReduction*>& due,
+                     const std::map<std::string, Vector<const MultiFab*> >& vars,
+                     int step, Real time)
+{
+    const int finest_level = mesh.finestLevel();
+    //
+    // The reductions work on cells, so every variable must be cell-centered.
+    //
+    for (AmrReduction* r : due)
+    {
+        for (const auto& name : r->vars())
+        {
+            auto it = vars.find(name);
+            if (it == vars.end() || static_cast<int>(it->second.size()) <= finest_level)
+                amrex::Abort("AmrDiagnostics: no data for " + name + " in amr.diag." + r->name() + ".vars");
+            for (int lev = 0; lev <= finest_level; ++lev)
+                if (!it->second[lev]->ixType().cellCentered())
+                    amrex::Abort("AmrDiagnostics: " + name + " in amr.diag." + r->name()
+                                 + ".vars is not cell-centered");
+        }
+    }
+
+    createDirectory();
+    //
+    // 1 on the cells not covered by the next finer level.
+    //
+    Vector<std::unique_ptr<iMultiFab> > mask(finest_level+1);
+    Vector<const iMultiFab*> maskp(finest_level+1);
+
+    for (int lev = 0; lev <= finest_level; ++lev)
+    {
+        mask[lev].reset(new iMultiFab(mesh.boxArray(lev), mesh.DistributionMap(lev), 1, 0));
+        mask[lev]->setVal(1);
+        maskp[lev] = mask[lev].get();
+
+        if (lev < finest_level)
+        {
+            const BoxArray cfba = amrex::coarsen(mesh.boxArray(lev+1), mesh.refRatio(lev));
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+            {
+                std::vector< std::pair<int,Box> > isects;
+                for (MFIter mfi(*mask[lev]); mfi.isValid(); ++mfi)
+                {
+                    cfba.intersections(mfi.validbox(), isects);
+                    for (const auto& is : isects)
+                        (*mask[lev])[mfi].setVal(0, is.second, 0, 1);
+                }
+            }
+        }
+    }
+
+    for (AmrReduction* r : due)
+    {
+        Vector<Vector<const MultiFab*> > data(finest_level+1);
+        for (int lev = 0; lev <= finest_level; ++lev)
+            for (const auto& name : r->vars())
+                data[lev].push_back(vars.at(name)[lev]);
+
+        r->compute(mesh, data, maskp, step, time);
+    }
+}
+
+void
+AmrDiagnostics::flush ()
+{
+    if (ParallelDescriptor::IOProcessor())
+        DiagWriter::get().flush();
+}
+
+}
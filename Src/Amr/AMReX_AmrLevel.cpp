@@ -154,7 +154,22 @@ AmrLevel::writePlotFile (const std::string& dir,
 	}
     }
 
-    int n_data_items = plot_var_map.size();
+    //
+    // The cell centered derived quantities to write, all derived in one batch.
+    //
+    Vector<std::string> derive_names;
+    int num_derive = 0;
+    for (const auto& rec : derive_lst.dlist())
+    {
+        if (parent->isDerivePlotVar(rec.name()) &&
+            rec.deriveType() == IndexType::TheCellType())
+        {
+            derive_names.push_back(rec.name());
+            num_derive += rec.numDerive();
+        }
+    }
+
+    int n_data_items = plot_var_map.size() + num_derive;
 
     // get the time from the first State_Type
     // if the State_Type is ::Interval, this will get t^{n+1/2} instead of t^n
@@ -181,6 +196,12 @@ AmrLevel::writePlotFile (const std::string& dir,
 	    int comp = plot_var_map[i].second;
 	    os << desc_lst[typ].name(comp) << '\n';
         }
+        for (const auto& name : derive_names)
+        {
+            const DeriveRec* rec = derive_lst.get(name);
+            for (i = 0; i < rec->numDerive(); i++)
+                os << rec->variableName(i) << '\n';
+        }
 
         os << AMREX_SPACEDIM << '\n';
         os << parent->cumTime() << '\n';
@@ -266,7 +287,6 @@ AmrLevel::writePlotFile (const std::string& dir,
     //
     // We combine all of the multifabs -- state, derived, etc -- into one
     // multifab -- plotMF.
-    // NOTE: In this tutorial code, there is no derived data
     int       cnt   = 0;
     const int nGrow = 0;
     MultiFab  plotMF(grids,dmap,n_data_items,nGrow,MFInfo(),Factory());
@@ -282,6 +302,14 @@ AmrLevel::writePlotFile (const std::string& dir,
 	MultiFab::Copy(plotMF,*this_dat,comp,cnt,1,nGrow);
 	cnt++;
     }
+    //
+    // Derived data -- one FillPatch per state type for all of them.
+    //
+    if (derive_names.size() > 0)
+    {
+        derive(derive_names,cur_time,plotMF,cnt);
+        cnt += num_derive;
+    }
 
     //
     // Use the Full pathname when naming the MultiFab.
@@ -1486,10 +1514,10 @@ AmrLevel::FillCoarsePatch (MultiFab& mf,
         }
 
 #ifdef AMREX_USE_EB
-        MultiFab crseMF(crseBA,mf_DM,NComp,0,MFInfo(),
+        MultiFab crseMF(crseBA,mf_DM,NComp,0,MFInfo().SetNoInit(true),
                         EBFArrayBoxFactory(cgeom, crseBA, mf_DM, {0,0,0}, EBSupport::basic));
 #else
-	MultiFab crseMF(crseBA,mf_DM,NComp,0);
+	MultiFab crseMF(crseBA,mf_DM,NComp,0,MFInfo().SetNoInit(true));
 #endif
 
 	if ( level == 1 
@@ -1818,6 +1846,199 @@ AmrLevel::derive (const std::string& name,
     }
 }
 
+void
+AmrLevel::derive (const Vector<std::string>& names,
+                  Real                       time,
+                  MultiFab&                  mf,
+                  int                        dcomp)
+{
+    BL_PROFILE("AmrLevel::derive(names)");
+
+    const int ngrow  = mf.nGrow();
+    const int nstate = desc_lst.size();
+    //
+    // Where each name goes in mf and what it needs: a state component
+    // to copy (rec == 0) or a DeriveRec to evaluate.
+    //
+    struct DeriveItem
+    {
+        const DeriveRec* rec;
+        int              index;
+        int              scomp;
+        int              dcomp;
+        int              ngrow_src;
+    };
+    std::vector<DeriveItem> items;
+    std::vector<std::pair<std::string,int> > others;
+    //
+    // The range of components and the ghost width needed from each state type.
+    //
+    Vector<int> lo_comp(nstate, std::numeric_limits<int>::max());
+    Vector<int> hi_comp(nstate, -1);
+    Vector<int> ngrow_st(nstate, 0);
+
+    int dc = dcomp;
+    for (const auto& name : names)
+    {
+        int index, scomp, ncomp;
+
+        if (isStateVariable(name, index, scomp))
+        {
+            lo_comp[index]  = std::min(lo_comp[index], scomp);
+            hi_comp[index]  = std::max(hi_comp[index], scomp);
+            ngrow_st[index] = std::max(ngrow_st[index], ngrow);
+
+            items.push_back({0, index, scomp, dc, ngrow});
+            dc += 1;
+        }
+        else if (const DeriveRec* rec = derive_lst.get(name))
+        {
+            BL_ASSERT(rec->deriveType() == mf.boxArray().ixType());
+
+            rec->getRange(0, index, scomp, ncomp);
+
+            int ngrow_src = ngrow;
+            {
+                Box bx0 = state[index].boxArray()[0];
+                Box bx1 = rec->boxMap()(bx0);
+                ngrow_src += bx0.smallEnd(0) - bx1.smallEnd(0);
+            }
+
+            for (int k = 0; k < rec->numRange(); ++k)
+            {
+                rec->getRange(k, index, scomp, ncomp);
+                lo_comp[index]  = std::min(lo_comp[index], scomp);
+                hi_comp[index]  = std::max(hi_comp[index], scomp+ncomp-1);
+                ngrow_st[index] = std::max(ngrow_st[index], ngrow_src);
+            }
+
+            items.push_back({rec, -1, -1, dc, ngrow_src});
+            dc += rec->numDerive();
+        }
+        else
+        {
+            //
+            // Not known here, maybe to a derived class' derive().
+            //
+            others.push_back(std::make_pair(name, dc));
+            dc += 1;
+        }
+    }
+
+    BL_ASSERT(dc <= mf.nComp());
+    //
+    // One FillPatch per state type, of all the components any name needs.
+    //
+    Vector<std::unique_ptr<MultiFab> > srcMF(nstate);
+
+    for (int index = 0; index < nstate; ++index)
+    {
+        if (hi_comp[index] < 0) continue;
+
+        const int ncomp = hi_comp[index] - lo_comp[index] + 1;
+        srcMF[index].reset(new MultiFab(state[index].boxArray(), dmap, ncomp, ngrow_st[index],
+                                        MFInfo(), *m_factory));
+        FillPatch(*this, *srcMF[index], ngrow_st[index], time, index, lo_comp[index], ncomp);
+    }
+    //
+    // Evaluate everything in one pass over the tiles.
+    //
+#if defined(AMREX_CRSEGRNDOMP) || (!defined(AMREX_XSDK) && defined(CRSEGRNDOMP))
+    const bool do_tiling = true;
+#else
+    const bool do_tiling = false;
+#endif
+    const Real* dx = geom.CellSize();
+    Real        dt = parent->dtLevel(level);
+
+#ifdef _OPENMP
+#pragma omp parallel if (do_tiling)
+#endif
+    {
+        FArrayBox gathered;
+
+        for (MFIter mfi(mf,do_tiling); mfi.isValid(); ++mfi)
+        {
+            int         grid_no = mfi.index();
+            FArrayBox&  dfab    = mf[mfi];
+            const int*  dlo     = dfab.loVect();
+            const int*  dhi     = dfab.hiVect();
+            const Box&  gtbx    = mfi.growntilebox();
+            const int*  lo      = gtbx.loVect();
+            const int*  hi      = gtbx.hiVect();
+            const RealBox temp    (gtbx,geom.CellSize(),geom.ProbLo());
+            const Real* xlo     = temp.lo();
+
+            for (const auto& it : items)
+            {
+                if (it.rec == 0)
+                {
+                    dfab.copy((*srcMF[it.index])[mfi], gtbx, it.scomp-lo_comp[it.index],
+                              gtbx, it.dcomp, 1);
+                    continue;
+                }
+
+                const DeriveRec* rec = it.rec;
+                int index, scomp, ncomp;
+                rec->getRange(0, index, scomp, ncomp);
+
+                const FArrayBox* cfab = &(*srcMF[index])[mfi];
+                int              coff = scomp - lo_comp[index];
+
+                if (rec->numRange() > 1)
+                {
+                    //
+                    // The ranges are not adjacent in srcMF; gather them.
+                    //
+                    const Box sbx = amrex::grow(gtbx, it.ngrow_src-ngrow);
+                    gathered.resize(sbx, rec->numState());
+                    for (int k = 0, gc = 0; k < rec->numRange(); k++, gc += ncomp)
+                    {
+                        rec->getRange(k, index, scomp, ncomp);
+                        gathered.copy((*srcMF[index])[mfi], sbx, scomp-lo_comp[index], sbx, gc, ncomp);
+                    }
+                    cfab = &gathered;
+                    coff = 0;
+                    rec->getRange(0, index, scomp, ncomp);
+                }
+
+                Real*       ddat    = dfab.dataPtr(it.dcomp);
+                int         n_der   = rec->numDerive();
+                Real*       cdat    = const_cast<Real*>(cfab->dataPtr(coff));
+                const int*  clo     = cfab->loVect();
+                const int*  chi     = cfab->hiVect();
+                int         n_state = rec->numState();
+                const int*  dom_lo  = state[index].getDomain().loVect();
+                const int*  dom_hi  = state[index].getDomain().hiVect();
+                const int*  bcr     = rec->getBC();
+
+                if (rec->derFunc() != static_cast<DeriveFunc>(0)){
+                    rec->derFunc()(ddat,AMREX_ARLIM(dlo),AMREX_ARLIM(dhi),&n_der,
+                                   cdat,AMREX_ARLIM(clo),AMREX_ARLIM(chi),&n_state,
+                                   lo,hi,dom_lo,dom_hi,dx,xlo,&time,&dt,bcr,
+                                   &level,&grid_no);
+                } else if (rec->derFunc3D() != static_cast<DeriveFunc3D>(0)){
+                    rec->derFunc3D()(ddat,AMREX_ARLIM_3D(dlo),AMREX_ARLIM_3D(dhi),&n_der,
+                                     cdat,AMREX_ARLIM_3D(clo),AMREX_ARLIM_3D(chi),&n_state,
+                                     AMREX_ARLIM_3D(lo),AMREX_ARLIM_3D(hi),
+                                     AMREX_ARLIM_3D(dom_lo),AMREX_ARLIM_3D(dom_hi),
+                                     AMREX_ZFILL(dx),AMREX_ZFILL(xlo),
+                                     &time,&dt,
+                                     AMREX_BCREC_3D(bcr),
+                                     &level,&grid_no);
+                } else {
+                    amrex::Error("AmrLevel::derive: no function available");
+                }
+            }
+        }
+    }
+
+    for (const auto& o : others)
+    {
+        derive(o.first, time, mf, o.second);
+    }
+}
+
 //! Update the distribution maps in StateData based on the size of the map
 void
 AmrLevel::UpdateDistributionMaps ( DistributionMapping& update_dmap )
@@ -2092,11 +2313,109 @@ AmrLevel::FillPatch(AmrLevel& amrlevel,
 {
     BL_ASSERT(dcomp+ncomp-1 <= leveldata.nComp());
     BL_ASSERT(boxGrow <= leveldata.nGrow());
+
+    if (boxGrow == 0 && FillPatchFromSameBoxes(amrlevel, leveldata, time, index, scomp, ncomp, dcomp)) {
+        return;
+    }
+
     FillPatchIterator fpi(amrlevel, leveldata, boxGrow, time, index, scomp, ncomp);
     const MultiFab& mf_fillpatched = fpi.get_mf();
     MultiFab::Copy(leveldata, mf_fillpatched, 0, dcomp, ncomp, boxGrow);
 }
 
+bool
+AmrLevel::FillPatchFromSameBoxes (AmrLevel& amrlevel,
+                                  MultiFab& leveldata,
+                                  Real      time,
+                                  int       index,
+                                  int       scomp,
+                                  int       ncomp,
+                                  int       dcomp)
+{
+    //
+    // This only works if the data of amrlevel at time is a single MultiFab
+    // (no interpolation in time) and leveldata needs no special factory.
+    //
+    Vector<MultiFab*> data;
+    Vector<Real>      datatime;
+    amrlevel.state[index].getData(data, datatime, time);
+
+    if (data.size() != 1 || dynamic_cast<const FArrayBoxFactory*>(&leveldata.Factory()) == nullptr) {
+        return false;
+    }
+
+    const MultiFab&            src   = *data[0];
+    const BoxArray&            sba   = src.boxArray();
+    const DistributionMapping& sdm   = src.DistributionMap();
+    const BoxArray&            dba   = leveldata.boxArray();
+    const DistributionMapping& ddm   = leveldata.DistributionMap();
+
+    if (sba.ixType() != dba.ixType()) {
+        return false;
+    }
+
+    BL_PROFILE("AmrLevel::FillPatchFromSameBoxes()");
+    //
+    // The boxes of leveldata that amrlevel has too, on the same process, and
+    // the other ones.
+    //
+    const int N = dba.size();
+    Vector<int> src_index(N, -1);
+    BoxList     other_boxes(dba.ixType());
+    Vector<int> other_pmap;
+    std::vector< std::pair<int,Box> > isects;
+
+    for (int k = 0; k < N; ++k)
+    {
+        const Box bx = dba[k];
+        sba.intersections(bx, isects);
+        for (const auto& is : isects)
+        {
+            if (is.second == bx && sba[is.first] == bx && sdm[is.first] == ddm[k])
+            {
+                src_index[k] = is.first;
+                break;
+            }
+        }
+        if (src_index[k] < 0)
+        {
+            other_boxes.push_back(bx);
+            other_pmap.push_back(ddm[k]);
+        }
+    }
+
+    if (int(other_pmap.size()) == N) {
+        return false;
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(leveldata); mfi.isValid(); ++mfi)
+    {
+        const int k = mfi.index();
+        if (src_index[k] >= 0) {
+            leveldata[mfi].copy(src[src_index[k]], scomp, dcomp, ncomp);
+        }
+    }
+
+    if (other_boxes.isNotEmpty())
+    {
+        //
+        // The rest is FillPatch'd as usual. These boxes live on the same
+        // processes as in leveldata, so the final copy is local.
+        //
+        BoxArray            oba(std::move(other_boxes));
+        DistributionMapping odm(std::move(other_pmap));
+        MultiFab            tmp(oba, odm, ncomp, 0);
+
+        FillPatchIterator fpi(amrlevel, tmp, 0, time, index, scomp, ncomp);
+        leveldata.copy(fpi.get_mf(), 0, dcomp, ncomp);
+    }
+
+    return true;
+}
+
 void
 AmrLevel::FillPatchAdd(AmrLevel& amrlevel,
 		       MultiFab& leveldata,
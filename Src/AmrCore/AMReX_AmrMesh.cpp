@@ -2,6 +2,7 @@
 #include <AMReX.H>
 #include <AMReX_AmrMesh.H>
 #include <AMReX_Cluster.H>
+#include <AMReX_FabArrayBase.H>
 #include <AMReX_ParmParse.H>
 #include <AMReX_ParallelDescriptor.H>
 #include <AMReX_Print.H>
@@ -340,6 +341,7 @@ void
 AmrMesh::SetBoxArray (int lev, const BoxArray& ba_in)
 {
     if (grids[lev] != ba_in) grids[lev] = ba_in;
+    if (FabArrayBase::compact_metadata) grids[lev].compact();
 }
 
 void
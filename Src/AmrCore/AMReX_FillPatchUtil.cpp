@@ -69,7 +69,7 @@ namespace amrex
 		sameba = true;
 	    } else {
 		raii.define(smf[0]->boxArray(), smf[0]->DistributionMap(), ncomp, 0,
-                            MFInfo(), smf[0]->Factory());
+                            MFInfo().SetNoInit(true), smf[0]->Factory());
 			    
 		dmf = &raii;
 		destcomp = 0;
@@ -164,7 +164,7 @@ namespace amrex
 
 	    if ( ! fpc.ba_crse_patch.empty())
 	    {
-		MultiFab mf_crse_patch(fpc.ba_crse_patch, fpc.dm_crse_patch, ncomp, 0, MFInfo(),
+		MultiFab mf_crse_patch(fpc.ba_crse_patch, fpc.dm_crse_patch, ncomp, 0, MFInfo().SetNoInit(true),
                                        *fpc.fact_crse_patch);
 		
                 mf_crse_patch.setDomainBndry(std::numeric_limits<Real>::quiet_NaN(), cgeom);
@@ -260,7 +260,7 @@ namespace amrex
         const FArrayBoxFactory factory{};
 #endif
 
-	MultiFab mf_crse_patch(ba_crse_patch, dm, ncomp, 0, MFInfo(), factory);
+	MultiFab mf_crse_patch(ba_crse_patch, dm, ncomp, 0, MFInfo().SetNoInit(true), factory);
 
         mf_crse_patch.setDomainBndry(std::numeric_limits<Real>::quiet_NaN(), cgeom);
 
@@ -25,6 +25,69 @@ int BF_init::m_cnt = 0;
 namespace
 {
     Arena* the_arena = 0;
+
+    //
+    // The part of a fab inside bx is a set of runs of contiguous memory.  If
+    // bx spans the fab in the first direction, the runs are longer than a
+    // row and we call f(ptr,n) on each of them in memory order and return
+    // true.  Otherwise the runs are single rows, which the Fortran kernels
+    // handle better, and we return false without calling f.
+    //
+    template <class FAB, class F>
+    bool
+    forEachRun (FAB& fab, const Box& bx, int comp, int ncomp, F f)
+    {
+        const auto& blen = bx.length3d();
+        const auto& flen = fab.box().length3d();
+
+        if (blen[0] != flen[0]) return false;
+
+        if (blen[1] == flen[1] && blen[2] == flen[2])
+        {
+            // The whole fab, so the components are contiguous too.
+            f(fab.dataPtr(comp), bx.numPts()*ncomp);
+        }
+        else if (blen[1] == flen[1])
+        {
+            for (int n = comp; n < comp+ncomp; ++n) {
+                f(fab.dataPtr(bx.smallEnd(),n), bx.numPts());
+            }
+        }
+        else
+        {
+            const long plane = static_cast<long>(blen[0])*blen[1];
+            const int* blo = bx.loVect();
+            for (int n = comp; n < comp+ncomp; ++n) {
+                for (int k = 0; k < blen[2]; ++k) {
+                    const IntVect plane_begin{AMREX_D_DECL(blo[0],
+                                                           blo[1],
+                                                           blo[2]+k)};
+                    f(fab.dataPtr(plane_begin,n), plane);
+                }
+            }
+        }
+        return true;
+    }
+
+    template <class T>
+    bool
+    copyRunsToMem (const BaseFab<T>& fab, const Box& bx, int comp, int ncomp, T* dst)
+    {
+        return forEachRun(fab, bx, comp, ncomp, [&dst] (const T* p, long n) {
+            std::memcpy(dst, p, n*sizeof(T));
+            dst += n;
+        });
+    }
+
+    template <class T>
+    bool
+    copyRunsFromMem (BaseFab<T>& fab, const Box& bx, int comp, int ncomp, const T* src)
+    {
+        return forEachRun(fab, bx, comp, ncomp, [&src] (T* p, long n) {
+            std::memcpy(p, src, n*sizeof(T));
+            src += n;
+        });
+    }
 }
 
 BF_init::BF_init ()
@@ -194,7 +257,11 @@ BaseFab<Real>::copyToMem (const Box& srcbox,
     BL_ASSERT(box().contains(srcbox));
     BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= nComp());
 
-    if (srcbox.ok())
+    if (srcbox.ok() && copyRunsToMem(*this, srcbox, srccomp, numcomp, static_cast<Real*>(dst)))
+    {
+        return sizeof(Real) * srcbox.numPts() * numcomp;
+    }
+    else if (srcbox.ok())
     {
 	long nreal =  amrex_fort_fab_copytomem(AMREX_ARLIM_3D(srcbox.loVect()), AMREX_ARLIM_3D(srcbox.hiVect()),
                                          static_cast<Real*>(dst),
@@ -218,7 +285,11 @@ BaseFab<Real>::copyFromMem (const Box&  dstbox,
     BL_ASSERT(box().contains(dstbox));
     BL_ASSERT(dstcomp >= 0 && dstcomp+numcomp <= nComp());
 
-    if (dstbox.ok()) 
+    if (dstbox.ok() && copyRunsFromMem(*this, dstbox, dstcomp, numcomp, static_cast<const Real*>(src)))
+    {
+        return sizeof(Real) * dstbox.numPts() * numcomp;
+    }
+    else if (dstbox.ok())
     {
 	long nreal = amrex_fort_fab_copyfrommem(AMREX_ARLIM_3D(dstbox.loVect()), AMREX_ARLIM_3D(dstbox.hiVect()),
                                           BL_TO_FORTRAN_N_3D(*this,dstcomp), &numcomp,
@@ -608,7 +679,11 @@ BaseFab<int>::copyToMem (const Box& srcbox,
     BL_ASSERT(box().contains(srcbox));
     BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= nComp());
 
-    if (srcbox.ok())
+    if (srcbox.ok() && copyRunsToMem(*this, srcbox, srccomp, numcomp, static_cast<int*>(dst)))
+    {
+        return sizeof(int) * srcbox.numPts() * numcomp;
+    }
+    else if (srcbox.ok())
     {
 	long nints =  amrex_fort_ifab_copytomem(AMREX_ARLIM_3D(srcbox.loVect()), AMREX_ARLIM_3D(srcbox.hiVect()),
                                           static_cast<int*>(dst),
@@ -632,7 +707,11 @@ BaseFab<int>::copyFromMem (const Box&  dstbox,
     BL_ASSERT(box().contains(dstbox));
     BL_ASSERT(dstcomp >= 0 && dstcomp+numcomp <= nComp());
 
-    if (dstbox.ok()) 
+    if (dstbox.ok() && copyRunsFromMem(*this, dstbox, dstcomp, numcomp, static_cast<const int*>(src)))
+    {
+        return sizeof(int) * dstbox.numPts() * numcomp;
+    }
+    else if (dstbox.ok())
     {
 	long nints = amrex_fort_ifab_copyfrommem(AMREX_ARLIM_3D(dstbox.loVect()), AMREX_ARLIM_3D(dstbox.hiVect()),
                                            BL_TO_FORTRAN_N_3D(*this,dstcomp), &numcomp,
@@ -5,6 +5,10 @@
 #include <AMReX_Utility.H>
 #include <AMReX_MFIter.H>
 #include <AMReX_BaseFab.H>
+#include <AMReX_ParmParse.H>
+
+#include <algorithm>
+#include <limits>
 
 #ifdef BL_MEM_PROFILING
 #include <AMReX_MemProfiler.H>
@@ -28,8 +32,97 @@ long BARef::total_hash_bytes_hwm = 0L;
 bool    BARef::initialized = false;
 bool BoxArray::initialized = false;
 
+Real BARef::bvh_threshold = 16.0;
+
 namespace {
     const int bl_ignore_max = 100000;
+    //
+    // BVH leaves hold at most this many boxes, and BoxArrays with fewer
+    // boxes than this many leaves always use the hash.
+    //
+    const int bvh_leaf_size  = 4;
+    const int bvh_min_leaves = 16;
+
+    int
+    buildBVHNode (const BARef& ref, Vector<int>& index, int begin, int end,
+                  Vector<BARef::BVHNode>& nodes)
+    {
+        const int inode = nodes.size();
+        nodes.push_back(BARef::BVHNode{ref.getBox(index[begin]), -1, -1, begin, end});
+
+        Box bbx = ref.getBox(index[begin]);
+        IntVect clo = bbx.smallEnd() + bbx.bigEnd();
+        IntVect chi = clo;
+        for (int i = begin+1; i < end; ++i) {
+            const Box& b = ref.getBox(index[i]);
+            bbx.minBox(b);
+            const IntVect& c = b.smallEnd() + b.bigEnd();
+            clo = amrex::min(clo, c);
+            chi = amrex::max(chi, c);
+        }
+        nodes[inode].bbox = bbx;
+
+        if (end - begin <= bvh_leaf_size) return inode;
+        //
+        // Split at the median box center along the direction in which the
+        // centers are spread the most.
+        //
+        int dir = 0;
+        for (int idim = 1; idim < AMREX_SPACEDIM; ++idim) {
+            if (chi[idim]-clo[idim] > chi[dir]-clo[dir]) dir = idim;
+        }
+        if (chi[dir] == clo[dir]) return inode;
+
+        const int mid = (begin + end) / 2;
+        std::nth_element(index.begin()+begin, index.begin()+mid, index.begin()+end,
+                         [&ref,dir] (int a, int b) -> bool {
+                             const Box& ba = ref.getBox(a);
+                             const Box& bb = ref.getBox(b);
+                             return ba.smallEnd(dir)+ba.bigEnd(dir)
+                                 <  bb.smallEnd(dir)+bb.bigEnd(dir);
+                         });
+
+        const int left  = buildBVHNode(ref, index, begin, mid, nodes);
+        const int right = buildBVHNode(ref, index, mid,   end, nodes);
+        nodes[inode].left  = left;
+        nodes[inode].right = right;
+
+        return inode;
+    }
+    //
+    // Call f(i) for every box i in abox that intersects bx, in no particular
+    // order, until f returns true.
+    //
+    template <class F>
+    void
+    queryBVH (const BARef& ref, const Box& bx, F&& f)
+    {
+        const auto& nodes = ref.bvh;
+        const auto& index = ref.bvh_index;
+
+        Vector<int> stack;
+        stack.reserve(64);
+        stack.push_back(0);
+
+        while (!stack.empty())
+        {
+            const BARef::BVHNode& node = nodes[stack.back()];
+            stack.pop_back();
+
+            if (!node.bbox.intersects(bx)) continue;
+
+            if (node.left < 0) {
+                for (int i = node.begin; i < node.end; ++i) {
+                    if (ref.getBox(index[i]).intersects(bx)) {
+                        if (f(index[i])) return;
+                    }
+                }
+            } else {
+                stack.push_back(node.right);
+                stack.push_back(node.left);
+            }
+        }
+    }
 }
 
 BARef::BARef () 
@@ -76,6 +169,13 @@ BARef::BARef (std::istream& is)
 BARef::BARef (const BARef& rhs) 
     : m_abox(rhs.m_abox) // don't copy hash
 {
+    if (rhs.isCompact()) { // the copy is about to be modified
+        const int N = rhs.size();
+        m_abox.resize(N);
+        for (int i = 0; i < N; ++i) {
+            m_abox[i] = rhs.getBox(i);
+        }
+    }
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(1);
 #endif	    
@@ -146,6 +246,7 @@ BARef::define (BoxList&& bl) noexcept
 
 void 
 BARef::resize (long n) {
+    expand();
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(-1);
     updateMemoryUsage_hash(-1);
@@ -153,6 +254,9 @@ BARef::resize (long n) {
     m_abox.resize(n);
     hash.clear();
     has_hashmap = false;
+    bvh.clear();
+    bvh_index.clear();
+    has_bvh = false;
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(1);
 #endif
@@ -162,8 +266,8 @@ BARef::resize (long n) {
 void
 BARef::updateMemoryUsage_box (int s)
 {
-    if (m_abox.size() > 1) {
-	long b = amrex::bytesOf(m_abox);
+    if (size() > 1) {
+	long b = amrex::bytesOf(m_abox) + amrex::bytesOf(m_cbox);
 	if (s > 0) {
 	    total_box_bytes += b;
 	    total_box_bytes_hwm = std::max(total_box_bytes_hwm, total_box_bytes);
@@ -179,12 +283,13 @@ BARef::updateMemoryUsage_box (int s)
 void
 BARef::updateMemoryUsage_hash (int s)
 {
-    if (hash.size() > 0) {
+    if (hash.size() > 0 || bvh.size() > 0) {
 	long b = sizeof(hash);
 	for (const auto& x: hash) {
 	    b += amrex::gcc_map_node_extra_bytes
 		+ sizeof(IntVect) + amrex::bytesOf(x.second);
 	}
+        b += amrex::bytesOf(bvh) + amrex::bytesOf(bvh_index);
 	if (s > 0) {
 	    total_hash_bytes += b;
 	    total_hash_bytes_hwm = std::max(total_hash_bytes_hwm, total_hash_bytes);
@@ -195,6 +300,101 @@ BARef::updateMemoryUsage_hash (int s)
 }
 #endif
 
+bool
+BARef::compact ()
+{
+    if (isCompact()) return true;
+
+    const long N = m_abox.size();
+    if (N == 0) return false;
+    //
+    // The coarse grid spacing is the greatest common divisor of the
+    // lengths and lower corner offsets.
+    //
+    IntVect lo = m_abox[0].smallEnd();
+    for (const Box& b : m_abox) {
+        if (!b.ok() || !b.cellCentered()) return false;
+        lo = amrex::min(lo, b.smallEnd());
+    }
+
+    auto gcd = [] (int a, int b) -> int {
+        while (b != 0) { int t = a % b; a = b; b = t; }
+        return a;
+    };
+
+    IntVect bf = IntVect::TheZeroVector();
+    for (const Box& b : m_abox) {
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            bf[idim] = gcd(bf[idim], b.smallEnd(idim)-lo[idim]);
+            bf[idim] = gcd(bf[idim], b.length(idim));
+        }
+    }
+
+    const int cmax = std::numeric_limits<std::uint16_t>::max();
+    for (const Box& b : m_abox) {
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            if ((b.smallEnd(idim)-lo[idim])/bf[idim] > cmax ||
+                b.length(idim)/bf[idim]-1 > cmax) {
+                return false;
+            }
+        }
+    }
+
+#ifdef BL_MEM_PROFILING
+    updateMemoryUsage_box(-1);
+#endif
+    Vector<std::uint16_t> cbox(2*AMREX_SPACEDIM*N);
+    for (long i = 0; i < N; ++i) {
+        const Box& b = m_abox[i];
+        std::uint16_t* p = &cbox[2*AMREX_SPACEDIM*i];
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            p[idim]                 = (b.smallEnd(idim)-lo[idim])/bf[idim];
+            p[idim+AMREX_SPACEDIM]  = b.length(idim)/bf[idim]-1;
+        }
+    }
+    m_clo = lo;
+    m_cbf = bf;
+    m_cbox = std::move(cbox);
+    Vector<Box>().swap(m_abox);
+#ifdef BL_MEM_PROFILING
+    updateMemoryUsage_box(1);
+#endif
+
+    return true;
+}
+
+void
+BARef::expand ()
+{
+    if (!isCompact()) return;
+
+#ifdef BL_MEM_PROFILING
+    updateMemoryUsage_box(-1);
+#endif
+    const int N = size();
+    m_abox.resize(N);
+    for (int i = 0; i < N; ++i) {
+        m_abox[i] = getBox(i);
+    }
+    Vector<std::uint16_t>().swap(m_cbox);
+#ifdef BL_MEM_PROFILING
+    updateMemoryUsage_box(1);
+#endif
+}
+
+bool
+BARef::sameBoxes (const BARef& rhs) const
+{
+    if (!isCompact() && !rhs.isCompact()) return m_abox == rhs.m_abox;
+
+    const long N = size();
+    if (rhs.size() != N) return false;
+    for (long i = 0; i < N; ++i) {
+        if (getBox(i) != rhs.getBox(i)) return false;
+    }
+    return true;
+}
+
 void
 BARef::Initialize ()
 {
@@ -231,6 +431,9 @@ BoxArray::Initialize ()
     if (!initialized) {
 	initialized = true;
 	BARef::Initialize();
+
+        ParmParse pp("boxarray");
+        pp.query("bvh_threshold", BARef::bvh_threshold);
     }
 
     amrex::ExecOnFinalize(BoxArray::Finalize);
@@ -463,13 +666,13 @@ BoxArray::operator== (const BoxArray& rhs) const
 {
     if (m_simple && rhs.m_simple) {
         return m_typ == rhs.m_typ && m_crse_ratio == rhs.m_crse_ratio &&
-            (m_ref == rhs.m_ref || m_ref->m_abox == rhs.m_ref->m_abox);
+            (m_ref == rhs.m_ref || m_ref->sameBoxes(*rhs.m_ref));
     } else {
         return m_simple == rhs.m_simple
             && m_typ == rhs.m_typ
             && m_crse_ratio == rhs.m_crse_ratio
             && m_transformer->equal(*rhs.m_transformer)
-            && (m_ref == rhs.m_ref || m_ref->m_abox == rhs.m_ref->m_abox);
+            && (m_ref == rhs.m_ref || m_ref->sameBoxes(*rhs.m_ref));
     }
 }
 
@@ -483,7 +686,7 @@ bool
 BoxArray::CellEqual (const BoxArray& rhs) const
 {
     return m_crse_ratio == rhs.m_crse_ratio
-        && (m_ref == rhs.m_ref || m_ref->m_abox == rhs.m_ref->m_abox);
+        && (m_ref == rhs.m_ref || m_ref->sameBoxes(*rhs.m_ref));
 }
 
 BoxArray&
@@ -766,6 +969,7 @@ BoxArray::set (int        i,
         m_typ = ibox.ixType();
         m_transformer->setIxType(m_typ);
     }
+    m_ref->expand();
     m_ref->m_abox[i] = amrex::enclosedCells(ibox);
 }
 
@@ -907,14 +1111,14 @@ BoxArray::minimalBox () const
 #endif
 	if (use_single_thread)
 	{
-	    minbox = m_ref->m_abox[0];
+	    minbox = m_ref->getBox(0);
 	    for (int i = 1; i < N; ++i) {
-		minbox.minBox(m_ref->m_abox[i]);
+		minbox.minBox(m_ref->getBox(i));
 	    }
 	}
 	else
 	{
-	    Vector<Box> bxs(nthreads, m_ref->m_abox[0]);
+	    Vector<Box> bxs(nthreads, m_ref->getBox(0));
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -926,7 +1130,7 @@ BoxArray::minimalBox () const
 #pragma omp for
 #endif
 		for (int i = 0; i < N; ++i) {
-		    bxs[tid].minBox(m_ref->m_abox[i]);
+		    bxs[tid].minBox(m_ref->getBox(i));
 		}
 	    }
 	    minbox = bxs[0];
@@ -957,16 +1161,16 @@ BoxArray::minimalBox (int& npts_avg_box) const
 #endif
 	if (use_single_thread)
 	{
-	    minbox = m_ref->m_abox[0];
-            npts_tot += m_ref->m_abox[0].numPts();
+	    minbox = m_ref->getBox(0);
+            npts_tot += m_ref->getBox(0).numPts();
 	    for (int i = 1; i < N; ++i) {
-		minbox.minBox(m_ref->m_abox[i]);
-                npts_tot += m_ref->m_abox[i].numPts();
+		minbox.minBox(m_ref->getBox(i));
+                npts_tot += m_ref->getBox(i).numPts();
 	    }
 	}
 	else
 	{
-	    Vector<Box> bxs(nthreads, m_ref->m_abox[0]);
+	    Vector<Box> bxs(nthreads, m_ref->getBox(0));
 #ifdef _OPENMP
 #pragma omp parallel reduction(+:npts_tot)
 #endif
@@ -978,8 +1182,8 @@ BoxArray::minimalBox (int& npts_avg_box) const
 #pragma omp for
 #endif
 		for (int i = 0; i < N; ++i) {
-		    bxs[tid].minBox(m_ref->m_abox[i]);
-                    long npts = m_ref->m_abox[i].numPts();
+		    bxs[tid].minBox(m_ref->getBox(i));
+                    long npts = m_ref->getBox(i).numPts();
                     npts_tot += npts;
 		}
 	    }
@@ -1060,10 +1264,36 @@ BoxArray::intersections (const Box&                         bx,
 {
   // This is called too many times BL_PROFILE("BoxArray::intersections()");
 
-    BARef::HashType& BoxHashMap = getHashMap();
-
     isects.resize(0);
 
+    if (useBVH())
+    {
+        BL_ASSERT(bx.ixType() == ixType());
+
+        const Box& sbx = bvhSearchBox(amrex::grow(bx,ng));
+        if (!sbx.ok()) return;
+
+        bool super_simple = m_simple && m_crse_ratio==1 && m_typ.cellCentered()
+            && !m_ref->isCompact();
+        auto& abox = m_ref->m_abox;
+
+        queryBVH(*m_ref, sbx, [&] (int index) -> bool
+        {
+            const Box& ibox = super_simple ? abox[index] : (*this)[index];
+            const Box& isect = bx & amrex::grow(ibox,ng);
+
+            if (isect.ok())
+            {
+                isects.push_back(std::pair<int,Box>(index,isect));
+                return first_only;
+            }
+            return false;
+        });
+        return;
+    }
+
+    BARef::HashType& BoxHashMap = getHashMap();
+
     if (!BoxHashMap.empty())
     {
         BL_ASSERT(bx.ixType() == ixType());
@@ -1088,7 +1318,8 @@ BoxArray::intersections (const Box&                         bx,
 
 	auto TheEnd = BoxHashMap.cend();
 
-        bool super_simple = m_simple && m_crse_ratio==1 && m_typ.cellCentered();
+        bool super_simple = m_simple && m_crse_ratio==1 && m_typ.cellCentered()
+            && !m_ref->isCompact();
         auto& abox = m_ref->m_abox;
 
         for (IntVect iv = cbx.smallEnd(), End = cbx.bigEnd(); iv <= End; cbx.next(iv))
@@ -1128,7 +1359,40 @@ BoxArray::complementIn (BoxList& bl, const Box& bx) const
     bl.set(bx.ixType());
     bl.push_back(bx);
 
-    if (!empty()) 
+    if (!empty() && useBVH())
+    {
+	BL_ASSERT(bx.ixType() == ixType());
+
+        const Box& sbx = bvhSearchBox(bx);
+        if (!sbx.ok()) return;
+
+        BoxList newbl(bl.ixType());
+        newbl.reserve(bl.capacity());
+        BoxList newdiff(bl.ixType());
+
+        bool super_simple = m_simple && m_crse_ratio==1 && m_typ.cellCentered()
+            && !m_ref->isCompact();
+        auto& abox = m_ref->m_abox;
+
+        queryBVH(*m_ref, sbx, [&] (int index) -> bool
+        {
+            const Box& isect = (super_simple)
+                ? (bx & abox[index])
+                : (bx & (*this)[index]);
+
+            if (isect.ok())
+            {
+                newbl.clear();
+                for (const Box& b : bl) {
+                    amrex::boxDiff(newdiff, b, isect);
+                    newbl.join(newdiff);
+                }
+                bl.swap(newbl);
+            }
+            return bl.isEmpty();
+        });
+    }
+    else if (!empty()) 
     {
 	BARef::HashType& BoxHashMap = getHashMap();
 
@@ -1158,7 +1422,8 @@ BoxArray::complementIn (BoxList& bl, const Box& bx) const
         newbl.reserve(bl.capacity());
         BoxList newdiff(bl.ixType());
 
-        bool super_simple = m_simple && m_crse_ratio==1 && m_typ.cellCentered();
+        bool super_simple = m_simple && m_crse_ratio==1 && m_typ.cellCentered()
+            && !m_ref->isCompact();
         auto& abox = m_ref->m_abox;
 
 	for (IntVect iv = cbx.smallEnd(), End = cbx.bigEnd(); 
@@ -1193,13 +1458,16 @@ BoxArray::complementIn (BoxList& bl, const Box& bx) const
 void
 BoxArray::clear_hash_bin () const
 {
-    if (!m_ref->hash.empty())
+    if (!m_ref->hash.empty() || !m_ref->bvh.empty())
     {
 #ifdef BL_MEM_PROFILING
 	m_ref->updateMemoryUsage_hash(-1);
 #endif
         m_ref->hash.clear();
         m_ref->has_hashmap = false;
+        m_ref->bvh.clear();
+        m_ref->bvh_index.clear();
+        m_ref->has_bvh = false;
     }
 }
 
@@ -1218,8 +1486,11 @@ BoxArray::removeOverlap (bool simplify)
     }
 
     uniqify();
-
-    BARef::HashType& BoxHashMap = m_ref->hash;
+    //
+    // Boxes are added to the hash as we go, so make sure it, rather than
+    // the BVH, is used for the intersections.
+    //
+    BARef::HashType& BoxHashMap = getHashMap();
 
     const Box EmptyBox;
 
@@ -1332,20 +1603,21 @@ BoxArray::getHashMap () const
             // Calculate the bounding box & maximum extent of the boxes.
             //
 	    IntVect maxext = IntVect::TheUnitVector();
-            Box boundingbox = m_ref->m_abox[0];
+            Box boundingbox = m_ref->getBox(0);
 
 	    const int N = size();
 	    for (int i = 0; i < N; ++i)
             {
-                const Box& bx = m_ref->m_abox[i];
+                const Box& bx = m_ref->getBox(i);
                 maxext = amrex::max(maxext, bx.size());
                 boundingbox.minBox(bx);
             }
 
             for (int i = 0; i < N; i++)
             {
+                const Box& bx = m_ref->getBox(i);
                 const IntVect& crsnsmlend 
-		    = amrex::coarsen(m_ref->m_abox[i].smallEnd(),maxext);
+		    = amrex::coarsen(bx.smallEnd(),maxext);
                 BoxHashMap[crsnsmlend].push_back(i);
             }
 
@@ -1364,11 +1636,96 @@ BoxArray::getHashMap () const
     return BoxHashMap;
 }
 
+bool
+BoxArray::compact ()
+{
+    if (m_ref->isCompact()) return true;
+    if (!m_ref->compact()) return false;
+    // The hash was built on the expanded boxes and is the larger index.
+    clear_hash_bin();
+    return true;
+}
+
+bool
+BoxArray::useBVH () const
+{
+    if (m_ref->HasHashMap()) return false;
+    if (m_ref->HasBVH())     return true;
+
+    const int N = size();
+    if (BARef::bvh_threshold < 0.0) return false;
+    if (N < bvh_leaf_size*bvh_min_leaves && !m_ref->isCompact()) return false;
+
+#ifdef _OPENMP
+    #pragma omp critical(intersections_lock)
+#endif
+    {
+        if (m_ref->hash.empty() && m_ref->bvh.empty())
+        {
+            //
+            // The hash bins are sized by the largest box.  When that is much
+            // larger than a typical box each bin holds many boxes, and the
+            // BVH does better.
+            //
+            IntVect maxext = IntVect::TheUnitVector();
+            Array<Real,AMREX_SPACEDIM> sumext {AMREX_D_DECL(0.,0.,0.)};
+            for (int i = 0; i < N; ++i)
+            {
+                const IntVect& ext = m_ref->getBox(i).size();
+                maxext = amrex::max(maxext, ext);
+                for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                    sumext[idim] += ext[idim];
+                }
+            }
+
+            Real spread = 1.0;
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                spread *= maxext[idim] * N / std::max(sumext[idim], Real(1.0));
+            }
+
+            if (spread > BARef::bvh_threshold || m_ref->isCompact())
+            {
+                auto& index = m_ref->bvh_index;
+                index.resize(N);
+                for (int i = 0; i < N; ++i) index[i] = i;
+
+                m_ref->bvh.reserve(2*N/bvh_leaf_size+1);
+                buildBVHNode(*m_ref, index, 0, N, m_ref->bvh);
+
+                m_ref->has_bvh = true;
+
+#ifdef BL_MEM_PROFILING
+                m_ref->updateMemoryUsage_hash(1);
+#endif
+            }
+        }
+    }
+
+    return m_ref->HasBVH();
+}
+
+Box
+BoxArray::bvhSearchBox (const Box& gbx) const
+{
+    //
+    // Cell-centered box in the index space of m_abox that holds every box
+    // whose transformed box may intersect gbx.  This is the same as the
+    // search region of the hash without its binning.
+    //
+    const IntVect& doilo = getDoiLo();
+    const IntVect& doihi = getDoiHi();
+
+    Box sbx(gbx.smallEnd()-doihi, gbx.bigEnd()+doilo);
+    sbx.refine(m_crse_ratio);
+    return sbx;
+}
+
 void
 BoxArray::uniqify ()
 {
     if (m_ref.use_count() == 1) {
         clear_hash_bin();
+        m_ref->expand();
     } else {
 	auto p = std::make_shared<BARef>(*m_ref);
 	std::swap(m_ref,p);
@@ -1,4 +1,8 @@
 
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
 #include <AMReX_FabArrayBase.H>
 #include <AMReX_ParmParse.H>
 #include <AMReX_Utility.H>
@@ -19,6 +23,9 @@ namespace amrex {
 // Set default values in Initialize()!!!
 //
 bool    FabArrayBase::do_async_sends;
+bool    FabArrayBase::pipeline_comm;
+bool    FabArrayBase::compact_metadata;
+int     FabArrayBase::neighbor_collective_threshold;
 int     FabArrayBase::MaxComp;
 #if AMREX_SPACEDIM == 1
 IntVect FabArrayBase::mfiter_tile_size(1024000);
@@ -36,6 +43,8 @@ FabArrayBase::CPCache              FabArrayBase::m_TheCPCache;
 FabArrayBase::FPinfoCache          FabArrayBase::m_TheFillPatchCache;
 FabArrayBase::CFinfoCache          FabArrayBase::m_TheCrseFineCache;
 
+std::vector<FabArrayBase::CPCNeighborComm> FabArrayBase::m_TheCPCNeighborComms;
+
 FabArrayBase::CacheStats           FabArrayBase::m_TAC_stats("TileArrayCache");
 FabArrayBase::CacheStats           FabArrayBase::m_FBC_stats("FBCache");
 FabArrayBase::CacheStats           FabArrayBase::m_CPC_stats("CopyCache");
@@ -49,6 +58,60 @@ FabArrayBase::FabArrayStats        FabArrayBase::m_FA_stats;
 namespace
 {
     bool initialized = false;
+
+    //
+    // Evict the least recently used entries other than keep until cache is
+    // within its budget.  An entry may be filed under two keys, those of its
+    // source and of its destination.  The caches hold at most a few thousand
+    // entries, so a linear search is cheap next to rebuilding one.
+    //
+    template <class Cache, class T>
+    void
+    evictLRU (Cache& cache, FabArrayBase::CacheStats& stats, const T* keep)
+    {
+        while (stats.overBudget())
+        {
+            auto lru = cache.end();
+            for (auto it = cache.begin(); it != cache.end(); ++it)
+            {
+                if (it->second != keep &&
+                    (lru == cache.end() || it->second->m_last_use < lru->second->m_last_use))
+                {
+                    lru = it;
+                }
+            }
+
+            if (lru == cache.end()) break;
+
+            T* p = lru->second;
+            for (auto it = cache.begin(); it != cache.end(); )
+            {
+                if (it->second == p) {
+                    it = cache.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            stats.bytes -= p->bytes();
+            stats.recordEvict(p->m_nuse);
+            delete p;
+        }
+    }
+
+    void
+    printTop (const std::string& what, int ntop,
+              std::vector<std::pair<long,std::string> >& entries)
+    {
+        std::sort(entries.begin(), entries.end(),
+                  [] (const std::pair<long,std::string>& a, const std::pair<long,std::string>& b)
+                  { return a.first > b.first; });
+        amrex::Print(Print::AllProcs) << "    " << what << ":\n";
+        for (int i = 0, N = std::min(ntop, static_cast<int>(entries.size())); i < N; ++i) {
+            amrex::Print(Print::AllProcs) << "      " << std::setw(12) << entries[i].first
+                              << "  " << entries[i].second << "\n";
+        }
+    }
 }
 
 
@@ -75,6 +138,9 @@ FabArrayBase::Initialize ()
     //
     FabArrayBase::do_async_sends    = true;
     FabArrayBase::MaxComp           = 25;
+    FabArrayBase::pipeline_comm     = true;
+    FabArrayBase::compact_metadata  = false;
+    FabArrayBase::neighbor_collective_threshold = -1;
 
     ParmParse pp("fabarray");
 
@@ -97,10 +163,19 @@ FabArrayBase::Initialize ()
 
     pp.query("maxcomp",             FabArrayBase::MaxComp);
     pp.query("do_async_sends",      FabArrayBase::do_async_sends);
+    pp.query("pipeline_comm",       FabArrayBase::pipeline_comm);
+    pp.query("compact_metadata",    FabArrayBase::compact_metadata);
+    pp.query("neighbor_collective_threshold", FabArrayBase::neighbor_collective_threshold);
 
     if (MaxComp < 1)
         MaxComp = 1;
 
+    pp.query("fb_cache_max_bytes",        m_FBC_stats.max_bytes);
+    pp.query("cpc_cache_max_bytes",       m_CPC_stats.max_bytes);
+    pp.query("fpinfo_cache_max_bytes",    m_FPinfo_stats.max_bytes);
+    pp.query("cfinfo_cache_max_bytes",    m_CFinfo_stats.max_bytes);
+    pp.query("tilearray_cache_max_bytes", m_TAC_stats.max_bytes);
+
     amrex::ExecOnFinalize(FabArrayBase::Finalize);
 
 #ifdef BL_MEM_PROFILING
@@ -124,6 +199,13 @@ FabArrayBase::Initialize ()
 		     ([] () -> MemProfiler::MemInfo {
 			 return {m_CFinfo_stats.bytes, m_CFinfo_stats.bytes_hwm};
 		     }));
+    for (CacheStats* cs : {&m_TAC_stats, &m_FBC_stats, &m_CPC_stats, &m_FPinfo_stats, &m_CFinfo_stats})
+    {
+        MemProfiler::add(cs->name, std::function<MemProfiler::NBuildsInfo()>
+                         ([cs] () -> MemProfiler::NBuildsInfo {
+                             return {cs->size, cs->maxsize};
+                         }));
+    }
 #endif
 }
 
@@ -492,9 +574,7 @@ FabArrayBase::flushCPC (bool no_assertion) const
 	    }
 	}
 
-#ifdef BL_MEM_PROFILING
 	m_CPC_stats.bytes -= it->second->bytes();
-#endif
 	m_CPC_stats.recordErase(it->second->m_nuse);
 	delete it->second;
     }
@@ -506,6 +586,19 @@ FabArrayBase::flushCPC (bool no_assertion) const
     {
 	m_TheCPCache.erase(*it);
     }    
+
+    //
+    // The BDKey may be reused by a new BoxArray, so the neighborhood
+    // communicators of this one must not be found again.  They are only
+    // retired here, because MPI_Comm_free is collective and processes do
+    // not necessarily flush in the same order.  flushCPCache frees them.
+    //
+    for (auto& nbr : m_TheCPCNeighborComms)
+    {
+        if (nbr.m_srcbdk == m_bdkey || nbr.m_dstbdk == m_bdkey) {
+            nbr.m_retired = true;
+        }
+    }
 }
 
 void
@@ -519,9 +612,76 @@ FabArrayBase::flushCPCache ()
 	}
     }
     m_TheCPCache.clear();
-#ifdef BL_MEM_PROFILING
     m_CPC_stats.bytes = 0L;
+
+#ifdef BL_USE_MPI
+    //
+    // In the order they were created, which is the same on all processes.
+    //
+    for (auto& nbr : m_TheCPCNeighborComms) {
+        if (nbr.m_comm != MPI_COMM_NULL) {
+            BL_MPI_REQUIRE( MPI_Comm_free(&nbr.m_comm) );
+        }
+    }
 #endif
+    m_TheCPCNeighborComms.clear();
+}
+
+MPI_Comm
+FabArrayBase::getCPCNeighborComm (const CPC& cpc)
+{
+    const MPI_Comm parent = ParallelContext::CommunicatorSub();
+
+    for (auto const& nbr : m_TheCPCNeighborComms)
+    {
+        if (!nbr.m_retired &&
+            nbr.m_srcbdk == cpc.m_srcbdk &&
+            nbr.m_dstbdk == cpc.m_dstbdk &&
+            nbr.m_srcng  == cpc.m_srcng  &&
+            nbr.m_dstng  == cpc.m_dstng  &&
+            nbr.m_period == cpc.m_period &&
+            nbr.m_parent == parent)
+        {
+            return nbr.m_comm;
+        }
+    }
+
+    MPI_Comm comm = MPI_COMM_NULL;
+
+#if defined(BL_USE_MPI) && defined(MPI_VERSION) && (MPI_VERSION >= 3)
+    BL_PROFILE("FabArrayBase::getCPCNeighborComm()");
+
+    const int nsnds = cpc.m_SndVols->size();
+    const int nrcvs = cpc.m_RcvVols->size();
+    int nmsgs = std::max(nsnds, nrcvs);
+    BL_MPI_REQUIRE( MPI_Allreduce(MPI_IN_PLACE, &nmsgs, 1, MPI_INT, MPI_MAX, parent) );
+
+    if (nmsgs > 0 && nmsgs >= neighbor_collective_threshold)
+    {
+        //
+        // The neighbors are in the order of the send and receive maps, so
+        // that the counts of MPI_Neighbor_alltoallv line up with them.
+        //
+        Vector<int> sources, destinations;
+        sources.reserve(nrcvs);
+        destinations.reserve(nsnds);
+        for (auto const& kv : *cpc.m_RcvVols) {
+            sources.push_back(ParallelContext::global_to_local_rank(kv.first));
+        }
+        for (auto const& kv : *cpc.m_SndVols) {
+            destinations.push_back(ParallelContext::global_to_local_rank(kv.first));
+        }
+        BL_MPI_REQUIRE( MPI_Dist_graph_create_adjacent(parent,
+                                                       nrcvs, sources.data(), MPI_UNWEIGHTED,
+                                                       nsnds, destinations.data(), MPI_UNWEIGHTED,
+                                                       MPI_INFO_NULL, 0, &comm) );
+    }
+#endif
+
+    m_TheCPCNeighborComms.push_back({cpc.m_srcbdk, cpc.m_dstbdk, cpc.m_srcng, cpc.m_dstng,
+                                     cpc.m_period, parent, comm, false});
+
+    return comm;
 }
 
 const FabArrayBase::CPC&
@@ -550,6 +710,7 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
 	{
 	    ++(it->second->m_nuse);
 	    m_CPC_stats.recordUse();
+	    it->second->m_last_use = m_CPC_stats.nuse;
 	    return *(it->second);
 	}
     }
@@ -557,19 +718,19 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
     // Have to build a new one
     CPC* new_cpc = new CPC(*this, dstng, src, srcng, period);
 
-#ifdef BL_MEM_PROFILING
-    m_CPC_stats.bytes += new_cpc->bytes();
-    m_CPC_stats.bytes_hwm = std::max(m_CPC_stats.bytes_hwm, m_CPC_stats.bytes);
-#endif    
+    m_CPC_stats.recordBytes(new_cpc->bytes());
 
     new_cpc->m_nuse = 1;
     m_CPC_stats.recordBuild();
     m_CPC_stats.recordUse();
+    new_cpc->m_last_use = m_CPC_stats.nuse;
 
     m_TheCPCache.insert(er_it.second, CPCache::value_type(dstkey,new_cpc));
     if (srckey != dstkey)
 	m_TheCPCache.insert(          CPCache::value_type(srckey,new_cpc));
 
+    evictLRU(m_TheCPCache, m_CPC_stats, new_cpc);
+
     return *new_cpc;
 }
 
@@ -1008,9 +1169,7 @@ FabArrayBase::flushFB (bool no_assertion) const
     std::pair<FBCacheIter,FBCacheIter> er_it = m_TheFBCache.equal_range(m_bdkey);
     for (FBCacheIter it = er_it.first; it != er_it.second; ++it)
     {
-#ifdef BL_MEM_PROFILING
 	m_FBC_stats.bytes -= it->second->bytes();
-#endif
 	m_FBC_stats.recordErase(it->second->m_nuse);
 	delete it->second;
     }
@@ -1026,9 +1185,7 @@ FabArrayBase::flushFBCache ()
 	delete it->second;
     }
     m_TheFBCache.clear();
-#ifdef BL_MEM_PROFILING
     m_FBC_stats.bytes = 0L;
-#endif
 }
 
 const FabArrayBase::FB&
@@ -1050,6 +1207,7 @@ FabArrayBase::getFB (const IntVect& nghost, const Periodicity& period,
 	{
 	    ++(it->second->m_nuse);
 	    m_FBC_stats.recordUse();
+	    it->second->m_last_use = m_FBC_stats.nuse;
 	    return *(it->second);
 	}
     }
@@ -1057,17 +1215,17 @@ FabArrayBase::getFB (const IntVect& nghost, const Periodicity& period,
     // Have to build a new one
     FB* new_fb = new FB(*this, nghost, cross, period, enforce_periodicity_only);
 
-#ifdef BL_PROFILE
-    m_FBC_stats.bytes += new_fb->bytes();
-    m_FBC_stats.bytes_hwm = std::max(m_FBC_stats.bytes_hwm, m_FBC_stats.bytes);
-#endif
+    m_FBC_stats.recordBytes(new_fb->bytes());
 
     new_fb->m_nuse = 1;
     m_FBC_stats.recordBuild();
     m_FBC_stats.recordUse();
+    new_fb->m_last_use = m_FBC_stats.nuse;
 
     m_TheFBCache.insert(er_it.second, FBCache::value_type(m_bdkey,new_fb));
 
+    evictLRU(m_TheFBCache, m_FBC_stats, new_fb);
+
     return *new_fb;
 }
 
@@ -1176,6 +1334,7 @@ FabArrayBase::TheFPinfo (const FabArrayBase& srcfa,
 	{
 	    ++(it->second->m_nuse);
 	    m_FPinfo_stats.recordUse();
+	    it->second->m_last_use = m_FPinfo_stats.nuse;
 	    return *(it->second);
 	}
     }
@@ -1183,19 +1342,19 @@ FabArrayBase::TheFPinfo (const FabArrayBase& srcfa,
     // Have to build a new one
     FPinfo* new_fpc = new FPinfo(srcfa, dstfa, dstdomain, dstng, coarsener, cdomain);
 
-#ifdef BL_MEM_PROFILING
-    m_FPinfo_stats.bytes += new_fpc->bytes();
-    m_FPinfo_stats.bytes_hwm = std::max(m_FPinfo_stats.bytes_hwm, m_FPinfo_stats.bytes);
-#endif
-    
+    m_FPinfo_stats.recordBytes(new_fpc->bytes());
+
     new_fpc->m_nuse = 1;
     m_FPinfo_stats.recordBuild();
     m_FPinfo_stats.recordUse();
+    new_fpc->m_last_use = m_FPinfo_stats.nuse;
 
     m_TheFillPatchCache.insert(er_it.second, FPinfoCache::value_type(dstkey,new_fpc));
     if (srckey != dstkey)
 	m_TheFillPatchCache.insert(          FPinfoCache::value_type(srckey,new_fpc));
 
+    evictLRU(m_TheFillPatchCache, m_FPinfo_stats, new_fpc);
+
     return *new_fpc;
 }
 
@@ -1227,9 +1386,7 @@ FabArrayBase::flushFPinfo (bool no_assertion)
 	    }
 	} 
 
-#ifdef BL_MEM_PROFILING
 	m_FPinfo_stats.bytes -= it->second->bytes();
-#endif
 	m_FPinfo_stats.recordErase(it->second->m_nuse);
 	delete it->second;
     }
@@ -1337,6 +1494,7 @@ FabArrayBase::TheCFinfo (const FabArrayBase& finefa,
         {
             ++(it->second->m_nuse);
             m_CFinfo_stats.recordUse();
+            it->second->m_last_use = m_CFinfo_stats.nuse;
             return *(it->second);
         }
     }
@@ -1344,17 +1502,17 @@ FabArrayBase::TheCFinfo (const FabArrayBase& finefa,
     // Have to build a new one
     CFinfo* new_cfinfo = new CFinfo(finefa, finegm, ng, include_periodic, include_physbndry);
 
-#ifdef BL_MEM_PROFILING
-    m_CFinfo_stats.bytes += new_cfinfo->bytes();
-    m_CFinfo_stats.bytes_hwm = std::max(m_CFinfo_stats.bytes_hwm, m_CFinfo_stats.bytes);
-#endif
+    m_CFinfo_stats.recordBytes(new_cfinfo->bytes());
 
     new_cfinfo->m_nuse = 1;
     m_CFinfo_stats.recordBuild();
     m_CFinfo_stats.recordUse();
+    new_cfinfo->m_last_use = m_CFinfo_stats.nuse;
 
     m_TheCrseFineCache.insert(er_it.second, CFinfoCache::value_type(key,new_cfinfo));
 
+    evictLRU(m_TheCrseFineCache, m_CFinfo_stats, new_cfinfo);
+
     return *new_cfinfo;
 }
 
@@ -1365,18 +1523,100 @@ FabArrayBase::flushCFinfo (bool no_assertion)
     auto er_it = m_TheCrseFineCache.equal_range(m_bdkey);
     for (auto it = er_it.first; it != er_it.second; ++it)
     {
-#ifdef BL_MEM_PROFILING
         m_CFinfo_stats.bytes -= it->second->bytes();
-#endif
         m_CFinfo_stats.recordErase(it->second->m_nuse);
         delete it->second;
     }
     m_TheCrseFineCache.erase(er_it.first, er_it.second);
 }
 
+void
+FabArrayBase::printCacheDiagnostics (int ntop)
+{
+    using Entries = std::vector<std::pair<long,std::string> >;
+
+    auto report = [ntop] (const CacheStats& stats, Entries& hot, Entries& big)
+    {
+        amrex::Print(Print::AllProcs) << "### " << stats.name << " on rank "
+                                      << ParallelDescriptor::MyProc() << " ###\n"
+                                      << "    # of entries: " << stats.size
+                                      << ", bytes: " << stats.bytes
+                                      << ", max bytes: " << stats.max_bytes
+                                      << ", # of evictions: " << stats.nevict << "\n";
+        printTop("most used", ntop, hot);
+        printTop("largest (bytes)", ntop, big);
+    };
+
+    {
+        Entries hot, big;
+        for (const auto& kv : m_TheFBCache) {
+            const FB& fb = *kv.second;
+            std::ostringstream os;
+            os << kv.first << " ng " << fb.m_ngrow << " cross " << fb.m_cross
+               << " epo " << fb.m_epo;
+            hot.emplace_back(fb.m_nuse, os.str());
+            big.emplace_back(fb.bytes(), os.str());
+        }
+        report(m_FBC_stats, hot, big);
+    }
+    {
+        Entries hot, big;
+        for (const auto& kv : m_TheCPCache) {
+            const CPC& cpc = *kv.second;
+            if (kv.first != cpc.m_dstbdk) continue; // filed under both keys
+            std::ostringstream os;
+            os << "src " << cpc.m_srcbdk << " ng " << cpc.m_srcng
+               << " dst " << cpc.m_dstbdk << " ng " << cpc.m_dstng;
+            hot.emplace_back(cpc.m_nuse, os.str());
+            big.emplace_back(cpc.bytes(), os.str());
+        }
+        report(m_CPC_stats, hot, big);
+    }
+    {
+        Entries hot, big;
+        for (const auto& kv : m_TheFillPatchCache) {
+            const FPinfo& fpi = *kv.second;
+            if (kv.first != fpi.m_dstbdk) continue; // filed under both keys
+            std::ostringstream os;
+            os << "src " << fpi.m_srcbdk << " dst " << fpi.m_dstbdk
+               << " ng " << fpi.m_dstng;
+            hot.emplace_back(fpi.m_nuse, os.str());
+            big.emplace_back(fpi.bytes(), os.str());
+        }
+        report(m_FPinfo_stats, hot, big);
+    }
+    {
+        Entries hot, big;
+        for (const auto& kv : m_TheCrseFineCache) {
+            const CFinfo& cfi = *kv.second;
+            std::ostringstream os;
+            os << kv.first << " ng " << cfi.m_ng;
+            hot.emplace_back(cfi.m_nuse, os.str());
+            big.emplace_back(cfi.bytes(), os.str());
+        }
+        report(m_CFinfo_stats, hot, big);
+    }
+    {
+        Entries hot, big;
+        for (const auto& tao : m_TheTileArrayCache) {
+            for (const auto& tai : tao.second) {
+                std::ostringstream os;
+                os << tao.first << " tile " << tai.first.first;
+                hot.emplace_back(tai.second.nuse, os.str());
+                big.emplace_back(tai.second.bytes(), os.str());
+            }
+        }
+        report(m_TAC_stats, hot, big);
+    }
+}
+
 void
 FabArrayBase::Finalize ()
 {
+    if (ParallelDescriptor::IOProcessor() && amrex::system::verbose > 1) {
+        printCacheDiagnostics();
+    }
+
     FabArrayBase::flushFBCache();
     FabArrayBase::flushCPCache();
     FabArrayBase::flushTileArrayCache();
@@ -1420,19 +1660,22 @@ FabArrayBase::getTileArray (const IntVect& tilesize) const
 	    buildTileArray(tilesize, *p);
 	    p->nuse = 0;
 	    m_TAC_stats.recordBuild();
-#ifdef BL_MEM_PROFILING
-	    m_TAC_stats.bytes += p->bytes();
-	    m_TAC_stats.bytes_hwm = std::max(m_TAC_stats.bytes_hwm,
-					     m_TAC_stats.bytes);
-#endif
+	    m_TAC_stats.recordBytes(p->bytes());
 	}
 #ifdef _OPENMP
+#pragma omp atomic
+#endif
+        ++(p->nlock);
+#ifdef _OPENMP
 #pragma omp master
 #endif
 	{
 	    ++(p->nuse);
 	    m_TAC_stats.recordUse();
+	    p->last_use = m_TAC_stats.nuse;
         }
+
+        evictTileArrays(p);
     }
 
     return p;
@@ -1545,9 +1788,7 @@ FabArrayBase::flushTileArray (const IntVect& tileSize, bool no_assertion) const
 	    for (TAMap::const_iterator tai_it = tao_it->second.begin();
 		 tai_it != tao_it->second.end(); ++tai_it)
 	    {
-#ifdef BL_MEM_PROFILING
 		m_TAC_stats.bytes -= tai_it->second.bytes();
-#endif		
 		m_TAC_stats.recordErase(tai_it->second.nuse);
 	    }
 	    tao.erase(tao_it);
@@ -1558,9 +1799,7 @@ FabArrayBase::flushTileArray (const IntVect& tileSize, bool no_assertion) const
             const IntVect& crse_ratio = boxArray().crseRatio();
 	    TAMap::iterator tai_it = tai.find(std::pair<IntVect,IntVect>(tileSize,crse_ratio));
 	    if (tai_it != tai.end()) {
-#ifdef BL_MEM_PROFILING
 		m_TAC_stats.bytes -= tai_it->second.bytes();
-#endif		
 		m_TAC_stats.recordErase(tai_it->second.nuse);
 		tai.erase(tai_it);
 	    }
@@ -1581,9 +1820,58 @@ FabArrayBase::flushTileArrayCache ()
 	}
     }
     m_TheTileArrayCache.clear();
-#ifdef BL_MEM_PROFILING
     m_TAC_stats.bytes = 0L;
+}
+
+void
+FabArrayBase::releaseTileArray (const TileArray* ta)
+{
+#ifdef _OPENMP
+#pragma omp atomic
 #endif
+    --(ta->nlock);
+}
+
+void
+FabArrayBase::evictTileArrays (const TileArray* keep)
+{
+    // Called from getTileArray inside its critical section.  Tile arrays
+    // locked by an MFIter are never evicted.
+    while (m_TAC_stats.overBudget())
+    {
+        TACache::iterator lru_o = m_TheTileArrayCache.end();
+        TAMap::iterator   lru_i;
+
+        for (TACache::iterator tao_it = m_TheTileArrayCache.begin();
+             tao_it != m_TheTileArrayCache.end(); ++tao_it)
+        {
+            for (TAMap::iterator tai_it = tao_it->second.begin();
+                 tai_it != tao_it->second.end(); ++tai_it)
+            {
+                const TileArray& ta = tai_it->second;
+                int nlock;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+                nlock = ta.nlock;
+                if (&ta != keep && nlock == 0 &&
+                    (lru_o == m_TheTileArrayCache.end() || ta.last_use < lru_i->second.last_use))
+                {
+                    lru_o = tao_it;
+                    lru_i = tai_it;
+                }
+            }
+        }
+
+        if (lru_o == m_TheTileArrayCache.end()) break;
+
+        m_TAC_stats.bytes -= lru_i->second.bytes();
+        m_TAC_stats.recordEvict(lru_i->second.nuse);
+        lru_o->second.erase(lru_i);
+        if (lru_o->second.empty()) {
+            m_TheTileArrayCache.erase(lru_o);
+        }
+    }
 }
 
 void
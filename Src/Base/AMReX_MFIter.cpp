@@ -163,6 +163,7 @@ MFIter::Initialize ()
     else
     {
 	const FabArrayBase::TileArray* pta = fabArray.getTileArray(tile_size);
+	locked_tile_array.reset(pta);
 	
 	index_map            = &(pta->indexMap);
 	local_index_map      = &(pta->localIndexMap);
@@ -12,6 +12,7 @@
 #include <AMReX_BLProfiler.H>
 #include <AMReX_iMultiFab.H>
 #include <AMReX_BaseFab_f.H>
+#include <AMReX_ParmParse.H>
 
 #ifdef BL_MEM_PROFILING
 #include <AMReX_MemProfiler.H>
@@ -19,9 +20,105 @@
 
 namespace amrex {
 
+bool MultiFab::reproducible_reductions;
+
 namespace
 {
     bool initialized = false;
+    //
+    // Return the n values f(mfi,s) adds to s for each box of mf, with mfi
+    // untiled, in slots ordered by the global box index.  Each box is
+    // summed by one thread, so its slots do not depend on the number of
+    // threads.  The slots of boxes owned by other processes are -0.0.
+    //
+    template <class F>
+    Vector<Real>
+    BoxPartials (const FabArrayBase& mf, int n, F&& f)
+    {
+        Vector<Real> slots(mf.size()*n, -0.0);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            f(mfi, &slots[mfi.index()*n]);
+        }
+
+        return slots;
+    }
+    //
+    // Add to r[0:n) the sum over the boxes of mf of BoxPartials(mf,n,f),
+    // adding the boxes in the order of the global box index so that the
+    // result depends on neither the number of threads nor the number of
+    // processes.  Unless local, the slots are gathered on the I/O processor,
+    // summed there and the sums broadcast.
+    //
+    template <class F>
+    void
+    ReproducibleSum (const FabArrayBase& mf, Real* r, int n, bool local, F&& f)
+    {
+        const int nboxes = mf.size();
+        const Vector<Real> slots = BoxPartials(mf, n, std::forward<F>(f));
+
+#ifdef BL_USE_MPI
+        if (!local && ParallelDescriptor::NProcs() > 1)
+        {
+            const DistributionMapping& dm = mf.DistributionMap();
+            const int nprocs = ParallelDescriptor::NProcs();
+            const int root   = ParallelDescriptor::IOProcessorNumber();
+            const bool iamroot = ParallelDescriptor::MyProc() == root;
+
+            std::vector<int> rc(nprocs, 0), disp(nprocs, 0);
+            for (int ibox = 0; ibox < nboxes; ++ibox) {
+                rc[dm[ibox]] += n;
+            }
+            for (int p = 1; p < nprocs; ++p) {
+                disp[p] = disp[p-1] + rc[p-1];
+            }
+
+            // The local box indices are in increasing order.
+            Vector<Real> snd;
+            snd.reserve(mf.local_size()*n+1);
+            for (int K : mf.IndexArray()) {
+                snd.insert(snd.end(), &slots[K*n], &slots[K*n]+n);
+            }
+            Vector<Real> rcv(iamroot ? nboxes*n : 1);
+
+            ParallelDescriptor::Gatherv(snd.data(), static_cast<int>(snd.size()),
+                                        rcv.data(), rc, disp, root);
+
+            Vector<Real> tot(n, 0.0);
+            if (iamroot)
+            {
+                std::vector<int> pos(disp);
+                for (int ibox = 0; ibox < nboxes; ++ibox) {
+                    const int p = dm[ibox];
+                    for (int i = 0; i < n; ++i) {
+                        tot[i] += rcv[pos[p]+i];
+                    }
+                    pos[p] += n;
+                }
+            }
+            ParallelDescriptor::Bcast(tot.data(), n, root);
+
+            for (int i = 0; i < n; ++i) {
+                r[i] += tot[i];
+            }
+            return;
+        }
+#endif
+
+        Vector<Real> tot(n, 0.0);
+        for (int ibox = 0; ibox < nboxes; ++ibox) {
+            for (int i = 0; i < n; ++i) {
+                tot[i] += slots[ibox*n+i];
+            }
+        }
+        for (int i = 0; i < n; ++i) {
+            r[i] += tot[i];
+        }
+    }
 #ifdef BL_MEM_PROFILING
     int num_multifabs     = 0;
     int num_multifabs_hwm = 0;
@@ -39,6 +136,16 @@ MultiFab::Dot (const MultiFab& x, int xcomp,
 
     Real sm = 0.0;
 
+    if (reproducible_reductions)
+    {
+        ReproducibleSum(x, &sm, 1, local, [&] (const MFIter& mfi, Real* s)
+        {
+            const Box& bx = mfi.growntilebox(nghost);
+            s[0] += x[mfi].dot(bx,xcomp,y[mfi],bx,ycomp,numcomp);
+        });
+        return sm;
+    }
+
 #ifdef _OPENMP
 #pragma omp parallel reduction(+:sm)
 #endif
@@ -54,6 +161,23 @@ MultiFab::Dot (const MultiFab& x, int xcomp,
     return sm;
 }
 
+ReduceBatch::Future<Real>
+MultiFab::Dot (ReduceBatch& batch,
+               const MultiFab& x, int xcomp,
+               const MultiFab& y, int ycomp,
+               int numcomp, int nghost)
+{
+    if (reproducible_reductions)
+    {
+        return batch.RealOrderedSum(BoxPartials(x, 1, [&] (const MFIter& mfi, Real* s)
+        {
+            const Box& bx = mfi.growntilebox(nghost);
+            s[0] += x[mfi].dot(bx,xcomp,y[mfi],bx,ycomp,numcomp);
+        }));
+    }
+    return batch.RealSum(MultiFab::Dot(x, xcomp, y, ycomp, numcomp, nghost, true));
+}
+
 Real
 MultiFab::Dot (const iMultiFab& mask,
                const MultiFab& x, int xcomp,
@@ -69,6 +193,16 @@ MultiFab::Dot (const iMultiFab& mask,
 
     Real sm = 0.0;
 
+    if (reproducible_reductions)
+    {
+        ReproducibleSum(x, &sm, 1, local, [&] (const MFIter& mfi, Real* s)
+        {
+            const Box& bx = mfi.growntilebox(nghost);
+            s[0] += x[mfi].dotmask(mask[mfi],bx,xcomp,y[mfi],bx,ycomp,numcomp);
+        });
+        return sm;
+    }
+
 #ifdef _OPENMP
 #pragma omp parallel reduction(+:sm)
 #endif
@@ -433,6 +567,11 @@ MultiFab::Initialize ()
 
     amrex::ExecOnFinalize(MultiFab::Finalize);
 
+    MultiFab::reproducible_reductions = false;
+
+    ParmParse pp("multifab");
+    pp.query("reproducible_reductions", MultiFab::reproducible_reductions);
+
 #ifdef BL_MEM_PROFILING
     MemProfiler::add("MultiFab", std::function<MemProfiler::NBuildsInfo()>
 		     ([] () -> MemProfiler::NBuildsInfo {
@@ -473,7 +612,7 @@ MultiFab::MultiFab (const BoxArray&            bxs,
     :
     FabArray<FArrayBox>(bxs,dm,ncomp,ngrow,info,factory)
 {
-    if (SharedMemory() && info.alloc) initVal();  // else already done in FArrayBox
+    if (SharedMemory() && info.alloc && !info.noinit) initVal();  // else already done in FArrayBox
 #ifdef BL_MEM_PROFILING
     ++num_multifabs;
     num_multifabs_hwm = std::max(num_multifabs_hwm, num_multifabs);
@@ -548,7 +687,7 @@ MultiFab::define (const BoxArray&            bxs,
                   const FabFactory<FArrayBox>& factory)
 {
     this->FabArray<FArrayBox>::define(bxs,dm,nvar,ngrow,info,factory);
-    if (SharedMemory() && info.alloc) initVal();  // else already done in FArrayBox
+    if (SharedMemory() && info.alloc && !info.noinit) initVal();  // else already done in FArrayBox
 }
 
 void
@@ -1065,6 +1204,22 @@ MultiFab::norm2 (const Vector<int>& comps) const
     int n = comps.size();
     Vector<Real> nm2(n, 0.e0);
 
+    if (reproducible_reductions)
+    {
+        ReproducibleSum(*this, nm2.dataPtr(), n, false, [&] (const MFIter& mfi, Real* s)
+        {
+            const Box& bx = mfi.validbox();
+            const FArrayBox& fab = get(mfi);
+            for (int i=0; i<n; i++) {
+                s[i] += fab.dot(bx,comps[i],fab,bx,comps[i]);
+            }
+        });
+        for (int i=0; i<n; i++) {
+            nm2[i] = std::sqrt(nm2[i]);
+        }
+        return nm2;
+    }
+
 #ifdef _OPENMP
     int nthreads = omp_get_max_threads();
 #else
@@ -1128,6 +1283,15 @@ MultiFab::norm1 (int comp, int ngrow, bool local) const
     
     Real nm1 = 0.e0;
 
+    if (reproducible_reductions)
+    {
+        ReproducibleSum(*this, &nm1, 1, local, [&] (const MFIter& mfi, Real* s)
+        {
+            s[0] += get(mfi).norm(mfi.growntilebox(ngrow), 1, comp, 1);
+        });
+        return nm1;
+    }
+
 #ifdef _OPENMP
 #pragma omp parallel reduction(+:nm1)
 #endif
@@ -1150,6 +1314,18 @@ MultiFab::norm1 (const Vector<int>& comps, int ngrow, bool local) const
     int n = comps.size();
     Vector<Real> nm1(n, 0.e0);
 
+    if (reproducible_reductions)
+    {
+        ReproducibleSum(*this, nm1.dataPtr(), n, local, [&] (const MFIter& mfi, Real* s)
+        {
+            const Box& b = mfi.growntilebox(ngrow);
+            for (int i=0; i<n; i++) {
+                s[i] += get(mfi).norm(b, 1, comps[i], 1);
+            }
+        });
+        return nm1;
+    }
+
 #ifdef _OPENMP
     int nthreads = omp_get_max_threads();
 #else
@@ -1195,6 +1371,15 @@ MultiFab::sum (int comp, bool local) const
 {
     Real sm = 0.e0;
 
+    if (reproducible_reductions)
+    {
+        ReproducibleSum(*this, &sm, 1, local, [&] (const MFIter& mfi, Real* s)
+        {
+            s[0] += get(mfi).sum(mfi.validbox(), comp, 1);
+        });
+        return sm;
+    }
+
 #ifdef _OPENMP
 #pragma omp parallel reduction(+:sm)
 #endif
@@ -1209,6 +1394,73 @@ MultiFab::sum (int comp, bool local) const
     return sm;
 }
 
+ReduceBatch::Future<Real>
+MultiFab::min (ReduceBatch& batch, int comp, int nghost) const
+{
+    return batch.RealMin(min(comp, nghost, true));
+}
+
+ReduceBatch::Future<Real>
+MultiFab::max (ReduceBatch& batch, int comp, int nghost) const
+{
+    return batch.RealMax(max(comp, nghost, true));
+}
+
+ReduceBatch::Future<Real>
+MultiFab::norm0 (ReduceBatch& batch, int comp, int nghost) const
+{
+    return batch.RealMax(norm0(comp, nghost, true));
+}
+
+ReduceBatch::Future<Real>
+MultiFab::norm1 (ReduceBatch& batch, int comp, int ngrow) const
+{
+    if (reproducible_reductions)
+    {
+        return batch.RealOrderedSum(BoxPartials(*this, 1, [&] (const MFIter& mfi, Real* s)
+        {
+            s[0] += get(mfi).norm(mfi.growntilebox(ngrow), 1, comp, 1);
+        }));
+    }
+    return batch.RealSum(norm1(comp, ngrow, true));
+}
+
+ReduceBatch::Future<Real>
+MultiFab::norm2 (ReduceBatch& batch, int comp) const
+{
+    BL_ASSERT(ixType().cellCentered());
+
+    if (reproducible_reductions)
+    {
+        return batch.RealOrderedSum(BoxPartials(*this, 1, [&] (const MFIter& mfi, Real* s)
+        {
+            const Box& bx = mfi.validbox();
+            const FArrayBox& fab = get(mfi);
+            s[0] += fab.dot(bx,comp,fab,bx,comp);
+        })).then(+[] (Real x) -> Real { return std::sqrt(x); });
+    }
+
+    // Dot expects two MultiDabs. Make a copy to avoid aliasing.
+    MultiFab tmpmf(boxArray(), DistributionMap(), 1, 0, MFInfo(), Factory());
+    MultiFab::Copy(tmpmf, *this, comp, 0, 1, 0);
+
+    Real nm2 = MultiFab::Dot(*this, comp, tmpmf, 0, 1, 0, true);
+    return batch.RealSum(nm2).then(+[] (Real x) -> Real { return std::sqrt(x); });
+}
+
+ReduceBatch::Future<Real>
+MultiFab::sum (ReduceBatch& batch, int comp) const
+{
+    if (reproducible_reductions)
+    {
+        return batch.RealOrderedSum(BoxPartials(*this, 1, [&] (const MFIter& mfi, Real* s)
+        {
+            s[0] += get(mfi).sum(mfi.validbox(), comp, 1);
+        }));
+    }
+    return batch.RealSum(sum(comp, true));
+}
+
 void
 MultiFab::minus (const MultiFab& mf,
                  int             strt_comp,
@@ -1453,7 +1705,7 @@ MultiFab::SumBoundary (int scomp, int ncomp, const Periodicity& period)
 	// Self copy is safe only for cell-centered MultiFab
 	this->copy(*this,scomp,scomp,ncomp,n_grow,IntVect::TheZeroVector(),period,FabArrayBase::ADD);
     } else {
-	MultiFab tmp(boxArray(), DistributionMap(), ncomp, n_grow, MFInfo(), Factory());
+	MultiFab tmp(boxArray(), DistributionMap(), ncomp, n_grow, MFInfo().SetNoInit(true), Factory());
 	MultiFab::Copy(tmp, *this, scomp, 0, ncomp, n_grow[0]);
 	this->setVal(0.0, scomp, ncomp, 0);
 	this->copy(tmp,0,scomp,ncomp,n_grow,IntVect::TheZeroVector(),period,FabArrayBase::ADD);
@@ -1565,7 +1817,7 @@ MultiFab::WeightedSync (const MultiFab& wgt, const Periodicity& period)
         MultiFab::Multiply(*this, wgt, 0, comp, 1, 0);
     }
     
-    MultiFab tmpmf(boxArray(), DistributionMap(), ncomp, 0, MFInfo(), Factory());
+    MultiFab tmpmf(boxArray(), DistributionMap(), ncomp, 0, MFInfo().SetNoInit(true), Factory());
     tmpmf.setVal(0.0);
     tmpmf.ParallelCopy(*this, period, FabArrayBase::ADD);
 
@@ -1601,7 +1853,7 @@ MultiFab::OverrideSync (const iMultiFab& msk, const Periodicity& period)
                                 0.0);
     }
     
-    MultiFab tmpmf(boxArray(), DistributionMap(), ncomp, 0, MFInfo(), Factory());
+    MultiFab tmpmf(boxArray(), DistributionMap(), ncomp, 0, MFInfo().SetNoInit(true), Factory());
     tmpmf.setVal(0.0);
     tmpmf.ParallelCopy(*this, period, FabArrayBase::ADD);
 
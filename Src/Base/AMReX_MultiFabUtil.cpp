@@ -224,7 +224,7 @@ namespace amrex
         BoxArray crse_S_fine_BA = fine_BA; 
 	crse_S_fine_BA.coarsen(ratio);
 
-        MultiFab crse_S_fine(crse_S_fine_BA,fine_dm,ncomp,0,MFInfo(),FArrayBoxFactory());
+        MultiFab crse_S_fine(crse_S_fine_BA,fine_dm,ncomp,0,MFInfo().SetNoInit(true),FArrayBoxFactory());
 
 	MultiFab fvolume;
 	fgeom.GetVolume(fvolume, fine_BA, fine_dm, 0);
@@ -278,7 +278,7 @@ namespace amrex
         //
         BoxArray crse_S_fine_BA = S_fine.boxArray(); crse_S_fine_BA.coarsen(ratio);
 
-        MultiFab crse_S_fine(crse_S_fine_BA, S_fine.DistributionMap(), ncomp, nGrow, MFInfo(), FArrayBoxFactory());
+        MultiFab crse_S_fine(crse_S_fine_BA, S_fine.DistributionMap(), ncomp, nGrow, MFInfo().SetNoInit(true), FArrayBoxFactory());
 
 #ifdef _OPENMP
 #pragma omp parallel
@@ -340,7 +340,7 @@ namespace amrex
         }
         else
         {
-            MultiFab crse_S_fine(crse_S_fine_BA, S_fine.DistributionMap(), ncomp, 0, MFInfo(), FArrayBoxFactory());
+            MultiFab crse_S_fine(crse_S_fine_BA, S_fine.DistributionMap(), ncomp, 0, MFInfo().SetNoInit(true), FArrayBoxFactory());
 
 #ifdef _OPENMP
 #pragma omp parallel
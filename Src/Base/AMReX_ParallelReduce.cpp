@@ -0,0 +1,305 @@
+
+#include <AMReX_ParallelReduce.H>
+#include <AMReX_BLProfiler.H>
+
+#include <algorithm>
+#include <cstring>
+
+namespace amrex {
+
+namespace {
+
+#ifdef BL_USE_MPI
+    MPI_Op the_batch_op = MPI_OP_NULL;
+    //
+    // A batch is sent as one element of MPI_BYTEs laid out as
+    //
+    //   long nlsum, nlmin, nlmax, nrsum, nrmin, nrmax;
+    //   long lsum[nlsum], lmin[nlmin], lmax[nlmax];
+    //   Real rsum[nrsum], rmin[nrmin], rmax[nrmax];
+    //
+    // so that the operator can find its way through it.
+    //
+    const int batch_header = 6;
+
+    long
+    batchBytes (const long* h)
+    {
+        return (batch_header + h[0] + h[1] + h[2]) * sizeof(long)
+            +  (h[3] + h[4] + h[5]) * sizeof(Real);
+    }
+
+    template <typename T>
+    void
+    combine (const T* in, T* inout, long nsum, long nmin, long nmax)
+    {
+        for (long i = 0; i < nsum; ++i) {
+            inout[i] += in[i];
+        }
+        in += nsum; inout += nsum;
+        for (long i = 0; i < nmin; ++i) {
+            inout[i] = std::min(inout[i], in[i]);
+        }
+        in += nmin; inout += nmin;
+        for (long i = 0; i < nmax; ++i) {
+            inout[i] = std::max(inout[i], in[i]);
+        }
+    }
+
+    void
+    batchOp (void* invec, void* inoutvec, int* len, MPI_Datatype*)
+    {
+        char* pin    = static_cast<char*>(invec);
+        char* pinout = static_cast<char*>(inoutvec);
+        for (int k = 0; k < *len; ++k)
+        {
+            long h[batch_header];
+            std::memcpy(h, pinout, sizeof(h));
+            const long nbytes = batchBytes(h);
+
+            const long* lin    = reinterpret_cast<const long*>(pin) + batch_header;
+            long*       linout = reinterpret_cast<long*>(pinout)    + batch_header;
+            combine(lin, linout, h[0], h[1], h[2]);
+
+            const Real* rin    = reinterpret_cast<const Real*>(lin + h[0]+h[1]+h[2]);
+            Real*       rinout = reinterpret_cast<Real*>(linout + h[0]+h[1]+h[2]);
+            combine(rin, rinout, h[3], h[4], h[5]);
+
+            pin    += nbytes;
+            pinout += nbytes;
+        }
+    }
+
+    template <typename T>
+    char*
+    packBatch (char* p, const Vector<T>& v)
+    {
+        const long n = v.size() * sizeof(T);
+        if (n > 0) std::memcpy(p, v.data(), n);
+        return p + n;
+    }
+
+    template <typename T>
+    const char*
+    unpackBatch (const char* p, Vector<T>& v)
+    {
+        const long n = v.size() * sizeof(T);
+        if (n > 0) std::memcpy(v.data(), p, n);
+        return p + n;
+    }
+#endif
+
+}
+
+ReduceBatch::ReduceBatch (MPI_Comm comm)
+    : m_data(std::make_shared<Data>())
+{
+    m_data->comm = comm;
+}
+
+ReduceBatch::~ReduceBatch ()
+{
+    if (m_data->posted) m_data->wait();
+}
+
+template <typename T>
+ReduceBatch::Future<T>
+ReduceBatch::add (Vector<T>& v, T x)
+{
+    if (m_data->posted) {
+        amrex::Abort("ReduceBatch: cannot add to a batch after post()");
+    }
+    v.push_back(x);
+    return Future<T>(m_data, v, v.size()-1);
+}
+
+ReduceBatch::Future<Real> ReduceBatch::RealSum (Real v) { return add(m_data->rsum, v); }
+ReduceBatch::Future<Real> ReduceBatch::RealMin (Real v) { return add(m_data->rmin, v); }
+ReduceBatch::Future<Real> ReduceBatch::RealMax (Real v) { return add(m_data->rmax, v); }
+ReduceBatch::Future<Real>
+ReduceBatch::RealOrderedSum (Vector<Real>&& partials)
+{
+    if (m_data->posted) {
+        amrex::Abort("ReduceBatch: cannot add to a batch after post()");
+    }
+    Data& d = *m_data;
+    d.rord_begin.push_back(d.rsum.size());
+    d.rord_size.push_back(partials.size());
+    d.rsum.insert(d.rsum.end(), partials.begin(), partials.end());
+    Vector<Real>().swap(partials);
+    d.rord.push_back(0.0);
+    return Future<Real>(m_data, d.rord, d.rord.size()-1);
+}
+
+ReduceBatch::Future<long> ReduceBatch::LongSum (long v) { return add(m_data->lsum, v); }
+ReduceBatch::Future<long> ReduceBatch::LongMin (long v) { return add(m_data->lmin, v); }
+ReduceBatch::Future<long> ReduceBatch::LongMax (long v) { return add(m_data->lmax, v); }
+
+void
+ReduceBatch::post ()
+{
+    m_data->post();
+}
+
+void
+ReduceBatch::wait ()
+{
+    m_data->wait();
+}
+
+bool
+ReduceBatch::test ()
+{
+    return m_data->test();
+}
+
+bool
+ReduceBatch::posted () const
+{
+    return m_data->posted;
+}
+
+int
+ReduceBatch::size () const
+{
+    return m_data->rsum.size() + m_data->rmin.size() + m_data->rmax.size()
+        +  m_data->lsum.size() + m_data->lmin.size() + m_data->lmax.size();
+}
+
+void
+ReduceBatch::Finalize ()
+{
+#ifdef BL_USE_MPI
+    if (the_batch_op != MPI_OP_NULL) {
+        MPI_Op_free(&the_batch_op);
+        the_batch_op = MPI_OP_NULL;
+    }
+#endif
+}
+
+void
+ReduceBatch::Data::post ()
+{
+    if (posted) return;
+    posted = true;
+
+#ifdef BL_USE_MPI
+    BL_PROFILE("ReduceBatch::post()");
+
+#ifdef BL_LAZY
+    Lazy::EvalReduction();
+#endif
+
+    int nprocs;
+    BL_MPI_REQUIRE( MPI_Comm_size(comm, &nprocs) );
+    if (nprocs == 1) {
+        finish();
+        return;
+    }
+
+    if (the_batch_op == MPI_OP_NULL) {
+        BL_MPI_REQUIRE( MPI_Op_create(batchOp, 1, &the_batch_op) );
+        amrex::ExecOnFinalize(ReduceBatch::Finalize);
+    }
+
+    const long h[batch_header] = { static_cast<long>(lsum.size()),
+                                   static_cast<long>(lmin.size()),
+                                   static_cast<long>(lmax.size()),
+                                   static_cast<long>(rsum.size()),
+                                   static_cast<long>(rmin.size()),
+                                   static_cast<long>(rmax.size()) };
+    const long nbytes = batchBytes(h);
+
+    sndbuf.resize(nbytes);
+    rcvbuf.resize(nbytes);
+
+    char* p = sndbuf.data();
+    std::memcpy(p, h, sizeof(h));
+    p += sizeof(h);
+    p = packBatch(p, lsum);
+    p = packBatch(p, lmin);
+    p = packBatch(p, lmax);
+    p = packBatch(p, rsum);
+    p = packBatch(p, rmin);
+    p = packBatch(p, rmax);
+
+    BL_MPI_REQUIRE( MPI_Type_contiguous(nbytes, MPI_BYTE, &type) );
+    BL_MPI_REQUIRE( MPI_Type_commit(&type) );
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 3)
+    BL_MPI_REQUIRE( MPI_Iallreduce(sndbuf.data(), rcvbuf.data(), 1, type,
+                                   the_batch_op, comm, &req) );
+#else
+    BL_MPI_REQUIRE( MPI_Allreduce(sndbuf.data(), rcvbuf.data(), 1, type,
+                                  the_batch_op, comm) );
+    wait();
+#endif
+#else
+    finish();
+#endif
+}
+
+void
+ReduceBatch::Data::wait ()
+{
+    if (!posted) post();
+    if (done) return;
+
+#ifdef BL_USE_MPI
+    BL_PROFILE("ReduceBatch::wait()");
+
+    MPI_Status status;
+    BL_MPI_REQUIRE( MPI_Wait(&req, &status) );
+
+    const char* p = rcvbuf.data() + batch_header*sizeof(long);
+    p = unpackBatch(p, lsum);
+    p = unpackBatch(p, lmin);
+    p = unpackBatch(p, lmax);
+    p = unpackBatch(p, rsum);
+    p = unpackBatch(p, rmin);
+    p = unpackBatch(p, rmax);
+
+    BL_MPI_REQUIRE( MPI_Type_free(&type) );
+    Vector<char>().swap(sndbuf);
+    Vector<char>().swap(rcvbuf);
+#endif
+
+    finish();
+}
+
+void
+ReduceBatch::Data::finish ()
+{
+    for (int i = 0, n = rord.size(); i < n; ++i)
+    {
+        Real r = 0.0;
+        const Real* p = rsum.data() + rord_begin[i];
+        for (long k = 0; k < rord_size[i]; ++k) {
+            r += p[k];
+        }
+        rord[i] = r;
+    }
+    done = true;
+}
+
+bool
+ReduceBatch::Data::test ()
+{
+    if (!posted || done) return done;
+
+#ifdef BL_USE_MPI
+    int flag = 0;
+    MPI_Status status;
+    BL_MPI_REQUIRE( MPI_Test(&req, &flag, &status) );
+    if (flag) {
+        //
+        // MPI_Test has freed the request, so this only unpacks.
+        //
+        wait();
+    }
+#endif
+
+    return done;
+}
+
+}
@@ -386,9 +386,9 @@ namespace amrex
       vector<VoFStencil> stenvec(vofvec.size());
 
       // cast from VolIndex to BaseIndex
-      vector<shared_ptr<BaseIndex> >    dstVoF(vofvec.size());
+      Vector<shared_ptr<BaseIndex> >    dstVoF(vofvec.size());
       // cast from VoFStencil to BaseStencil
-      vector<shared_ptr<BaseStencil> > stencil(vofvec.size());
+      Vector<shared_ptr<BaseStencil> > stencil(vofvec.size());
 
       for(int ivec = 0; ivec < vofvec.size(); ivec++)
       {
@@ -1,11 +1,14 @@
 #include "AMReX_VCAggStencil.H"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace amrex
 {
 /**************/
   VCAggStencil::
-  VCAggStencil(const vector<shared_ptr<BaseIndex>   >    & a_dstVoFs,
-               const vector<shared_ptr<BaseStencil> >    & a_vofStencil,
+  VCAggStencil(const Vector<shared_ptr<BaseIndex>   >    & a_dstVoFs,
+               const Vector<shared_ptr<BaseStencil> >    & a_vofStencil,
                const EBCellFAB                           & a_phiData,
                const EBCellFAB                           & a_rhsData,
                const EBCellFAB                           & a_relCoef,
@@ -19,9 +22,10 @@ namespace amrex
     m_relAccess.resize(a_dstVoFs.size());
     m_alpAccess.resize(a_dstVoFs.size());
     m_iv.resize(a_dstVoFs.size());
+    //stored in the same (internal) order as the base class data
     for (int idst = 0; idst < a_dstVoFs.size(); idst++)
     {
-      const BaseIndex& dstVoF = *a_dstVoFs[idst];
+      const BaseIndex& dstVoF = *a_dstVoFs[m_dstIndex[idst]];
       m_phiAccess[idst].dataID = a_phiData.dataType(dstVoF);
       m_phiAccess[idst].offset = a_phiData.offset(dstVoF, 0);
       m_relAccess[idst].dataID = a_relCoef.dataType(dstVoF);
@@ -29,14 +33,15 @@ namespace amrex
       m_alpAccess[idst].dataID = a_alphaWt.dataType(dstVoF);
       m_alpAccess[idst].offset = a_alphaWt.offset(dstVoF, 0);
 
-      VolIndex* vofPtr = dynamic_cast<VolIndex*>(&(*a_dstVoFs[idst]));
+      VolIndex* vofPtr = dynamic_cast<VolIndex*>(&(*a_dstVoFs[m_dstIndex[idst]]));
       if(vofPtr == NULL)
       {
         amrex::Error("dynamic cast error--VCAggStencil just handles VolIndicies");
       }
       m_iv[idst] = vofPtr->gridIndex();
     }
-    m_cachePhi.resize( m_ebstencil.size(), vector<Real>(a_ncomp, 0.));
+    m_nCache = a_ncomp;
+    m_cachePhi.resize(numDst()*m_nCache, 0.);
   }
 /************/
   void
@@ -44,7 +49,7 @@ namespace amrex
   cachePhi(const EBCellFAB& a_phi) const
   {
     BL_PROFILE("VCAggStencil::cachePhi");
-    vector<const Real*> dataPtrsPhi(a_phi.numDataTypes());
+    Vector<const Real*> dataPtrsPhi(a_phi.numDataTypes());
     for (int ivar = 0; ivar < a_phi.nComp(); ivar++)
     {
       for (int ivec = 0; ivec < dataPtrsPhi.size(); ivec++)
@@ -52,10 +57,10 @@ namespace amrex
         dataPtrsPhi[ivec] = a_phi.dataPtr(ivec, ivar);
       }
 
-      for (int idst = 0; idst < m_ebstencil.size(); idst++)
+      for (int idst = 0; idst < numDst(); idst++)
       {
         const Real* phiPtr =  dataPtrsPhi[m_phiAccess[idst].dataID] + m_phiAccess[idst].offset;
-        m_cachePhi[idst][ivar] = *phiPtr;
+        m_cachePhi[idst*m_nCache + ivar] = *phiPtr;
       }
     }
   }
@@ -65,7 +70,7 @@ namespace amrex
   uncachePhi(EBCellFAB& a_phi) const
   {
     BL_PROFILE("VCAggSten::uncache");
-    vector<Real*> dataPtrsPhi(a_phi.numDataTypes());
+    Vector<Real*> dataPtrsPhi(a_phi.numDataTypes());
     for (int ivar = 0; ivar < a_phi.nComp(); ivar++)
     {
       for (int ivec = 0; ivec < dataPtrsPhi.size(); ivec++)
@@ -73,10 +78,10 @@ namespace amrex
         dataPtrsPhi[ivec] = a_phi.dataPtr(ivec, ivar);
       }
 
-      for (int idst = 0; idst < m_ebstencil.size(); idst++)
+      for (int idst = 0; idst < numDst(); idst++)
       {
         Real* phiPtr =  dataPtrsPhi[m_phiAccess[idst].dataID] + m_phiAccess[idst].offset;
-        *phiPtr = m_cachePhi[idst][ivar];
+        *phiPtr = m_cachePhi[idst*m_nCache + ivar];
       }
     }
   }
@@ -98,15 +103,15 @@ namespace amrex
     const int numtyperel = a_relCoef.numDataTypes();
     const int numtypealp = a_alphaWt.numDataTypes();
   
-    vector<const Real*> dataPtrsRhs(numtyperhs);
-    vector<const Real*> dataPtrsRel(numtyperel);
-    vector<const Real*> dataPtrsAlp(numtypealp);
+    Vector<const Real*> dataPtrsRhs(numtyperhs);
+    Vector<const Real*> dataPtrsRel(numtyperel);
+    Vector<const Real*> dataPtrsAlp(numtypealp);
     //phi is the source (what the stencil gets applied to)
     //and the destination (where the answer goes).   For the 
     //source, we need  the variable to be zero because the stencil
     //variable is taken into account in aggstencil
-    vector<const Real*> dataPtrsSrc(numtypephi);
-    vector<Real*>       dataPtrsDst(numtypephi);
+    Vector<const Real*> dataPtrsSrc(numtypephi);
+    Vector<Real*>       dataPtrsDst(numtypephi);
     int varDst = a_varDest;
     int varSrc = 0;  //stencil variable taken into account in aggstencil
     for (int ivec = 0; ivec < numtyperhs; ivec++)
@@ -133,8 +138,11 @@ namespace amrex
       dataPtrsRel[ivec] = a_relCoef.dataPtr(ivec, varDst);
     }
 
-    for (int idst = 0; idst < m_ebstencil.size(); idst++)
+    //this is gauss-seidel within a color, so it stays serial and
+    //goes through the vofs in the order they were given
+    for (int iorig = 0; iorig < numDst(); iorig++)
     {
+      int idst = m_internal[iorig];
       const IntVect& iv = m_iv[idst];
       bool doThisVoF = true;
       for (int idir = 0; idir < SpaceDim; idir++)
@@ -147,14 +155,6 @@ namespace amrex
       }
       if(doThisVoF)
       {
-//begin debug
-        int idebug = 0;
-        if((iv[0]==14) && (iv[1]==12))
-        {
-          idebug = 1;
-        }
-//end debug
-
         const Real* rhsiPtr =  dataPtrsRhs[m_dstAccess[idst].dataID] + m_dstAccess[idst].offset;
         const Real& rhsi = *rhsiPtr;
         const Real* relcoPtr =  dataPtrsRel[m_relAccess[idst].dataID] + m_relAccess[idst].offset;
@@ -163,13 +163,13 @@ namespace amrex
         const Real& alphaWeight = *alpWtPtr;
 
 
-        const stencil_t& ebstencil = m_ebstencil[idst];
         Real lphi = 0;
-        for (int isten = 0; isten < ebstencil.size(); isten++)
+        for (int isten = 0; isten < stenSize(idst); isten++)
         {
-          const Real& weight = ebstencil[isten].second;
-          const long& offset = ebstencil[isten].first.offset;
-          const int & dataID = ebstencil[isten].first.dataID;
+          long index = stenIndex(idst, isten);
+          const Real& weight = m_weight[index];
+          const long& offset = m_srcOffset[index];
+          const int & dataID = m_srcID[index];
           const Real& phiVal = *(dataPtrsSrc[dataID] + offset);
           lphi += phiVal*weight;
         }
@@ -179,10 +179,6 @@ namespace amrex
         lphi = a_beta*lphi + a_alpha*alphaWeight*phii;
 
         phii = phii + relco*(rhsi - lphi);
-
-//begin debug
-        idebug = 0;
-//end debug
       }
     }
   }
@@ -208,9 +204,9 @@ namespace amrex
     const int numtypephi = a_phi.numDataTypes();
     const int numtypealp = a_alp.numDataTypes();
   
-    vector<      Real*> dataPtrsLph(numtypelph);
-    vector<const Real*> dataPtrsPhi(numtypephi);
-    vector<const Real*> dataPtrsAlp(numtypealp);
+    Vector<      Real*> dataPtrsLph(numtypelph);
+    Vector<const Real*> dataPtrsPhi(numtypephi);
+    Vector<const Real*> dataPtrsAlp(numtypealp);
     //no stencils here so everything is on the same var
     for (int ivec = 0; ivec < numtypelph; ivec++)
     {
@@ -225,7 +221,11 @@ namespace amrex
       dataPtrsPhi[ivec] = a_phi.dataPtr(ivec, a_varDest);
     }
 
-    for (int idst = 0; idst < m_ebstencil.size(); idst++)
+#ifdef _OPENMP
+    bool threaded = m_threadSafe && (numDst() > s_blockSize) && !omp_in_parallel();
+#pragma omp parallel for if (threaded)
+#endif
+    for (int idst = 0; idst < numDst(); idst++)
     {
       Real*        lphiPtr    =  dataPtrsLph[m_dstAccess[idst].dataID] + m_dstAccess[idst].offset;
       Real&           lphi    = *lphiPtr;
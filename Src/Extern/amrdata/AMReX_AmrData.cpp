@@ -17,10 +17,22 @@ using std::strlen;
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <memory>
+#include <map>
 #include <cstdio>
+#include <cstring>
 using std::ios;
 using std::ifstream;
 
+#if defined(__unix__) || defined(__APPLE__)
+#define AMREX_AMRDATA_USE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #ifdef SHOWVAL
 #undef SHOWVAL
 #endif
@@ -106,6 +118,7 @@ namespace amrex {
 bool AmrData::verbose = false;
 int  AmrData::skipPltLines  = 0;
 int  AmrData::sBoundaryWidth = 0;
+bool AmrData::useMMap = false;
 
 // ---------------------------------------------------------------
 AmrData::AmrData() {
@@ -137,6 +150,8 @@ AmrData::~AmrData() {
        delete visMF[lev][i];
      }
    }
+
+   UnmapFiles();
 }
 
 
@@ -1722,13 +1737,210 @@ bool AmrData::DefineFab(int level, int componentIndex, int fabIndex) {
     int whichVisMF(compIndexToVisMFMap[componentIndex]);
     int whichVisMFComponent(compIndexToVisMFComponentMap[componentIndex]);
     dataGrids[level][componentIndex]->setFab(fabIndex,
-                visMF[level][whichVisMF]->readFAB(fabIndex, whichVisMFComponent));
+                ReadFab(level, whichVisMF, fabIndex, whichVisMFComponent));
     dataGridsDefined[level][componentIndex][fabIndex] = true;
   }
   return true;
 }
 
 
+// ---------------------------------------------------------------
+FArrayBox *AmrData::ReadFab(int level, int whichVisMF, int fabIndex, int whichComp) {
+  if(useMMap) {
+    Box fabBox;
+    RealDescriptor rd;
+    const char *data = MappedFabData(level, whichVisMF, fabIndex, whichComp, fabBox, rd);
+    if(data != nullptr) {
+      FArrayBox *fab = new FArrayBox(fabBox, 1);
+      if(rd == FPC::NativeRealDescriptor()) {
+        std::memcpy(fab->dataPtr(), data, fab->nBytes());
+      } else {
+        RealDescriptor::convertToNativeFormat(fab->dataPtr(), fabBox.numPts(),
+                                              const_cast<char *>(data), rd);
+      }
+      return fab;
+    }
+  }
+  return visMF[level][whichVisMF]->readFAB(fabIndex, whichComp);
+}
+
+
+// ---------------------------------------------------------------
+const char *AmrData::MappedFabData(int level, int whichVisMF, int fabIndex,
+                                   int whichComp, Box &fabBox, RealDescriptor &rd)
+{
+  const VisMF::Header &hdr = visMF[level][whichVisMF]->GetHeader();
+  const string &mfName = visMF[level][whichVisMF]->FabArrayName();
+  string fullName(mfName.substr(0, mfName.rfind('/') + 1));
+  fullName += hdr.m_fod[fabIndex].m_name;
+
+  auto mfit = mappedFiles.find(fullName);
+  if(mfit == mappedFiles.end()) {
+    MappedFile mappedFile = { nullptr, 0 };
+#ifdef AMREX_AMRDATA_USE_MMAP
+    int fd(open(fullName.c_str(), O_RDONLY));
+    if(fd >= 0) {
+      struct stat fileStat;
+      if(fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+        void *addr = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if(addr != MAP_FAILED) {
+          mappedFile.addr   = static_cast<char *>(addr);
+          mappedFile.length = fileStat.st_size;
+        }
+      }
+      close(fd);
+    }
+#endif
+    if(mappedFile.addr == nullptr && verbose) {
+      cerr << "AmrData::MappedFabData:  cannot map " << fullName
+           << ", reading with ifstreams." << endl;
+    }
+    // remember failures too so we do not retry for every fab
+    mfit = mappedFiles.insert(std::make_pair(fullName, mappedFile)).first;
+  }
+
+  const MappedFile &mappedFile = mfit->second;
+  long head(hdr.m_fod[fabIndex].m_head);
+  if(mappedFile.addr == nullptr || head < 0 ||
+     static_cast<size_t>(head) >= mappedFile.length)
+  {
+    return nullptr;
+  }
+
+  const char *fileEnd = mappedFile.addr + mappedFile.length;
+  const char *data = mappedFile.addr + head;
+  int nCompOnDisk(hdr.m_ncomp);
+  if(hdr.m_vers == VisMF::Header::Version_v1) {
+    // each fab is preceded by a one line header:  FAB rd box ncomp
+    const char *eol = static_cast<const char *>(std::memchr(data, '\n', fileEnd - data));
+    if(eol == nullptr) {
+      return nullptr;
+    }
+    std::istringstream fabHeader(string(data, eol));
+    char f(' '), a(' '), b(' '), c(':');
+    fabHeader >> f >> a >> b >> c;
+    if(f != 'F' || a != 'A' || b != 'B' || c == ':') {  // ---- the old FAB format
+      return nullptr;
+    }
+    fabHeader.putback(c);
+    fabHeader >> rd >> fabBox >> nCompOnDisk;
+    if(fabHeader.fail()) {
+      return nullptr;
+    }
+    data = eol + 1;
+  } else {
+    fabBox = hdr.m_ba[fabIndex];
+    fabBox.grow(hdr.m_ngrow);
+    rd = hdr.m_writtenRD;
+  }
+
+  if(whichComp < 0 || whichComp >= nCompOnDisk) {
+    return nullptr;
+  }
+  long bytesPerComp(fabBox.numPts() * rd.numBytes());
+  data += bytesPerComp * whichComp;
+  if(bytesPerComp > fileEnd - data) {
+    return nullptr;
+  }
+  return data;
+}
+
+
+// ---------------------------------------------------------------
+void AmrData::UnmapFiles() {
+  for(auto &mf : mappedFiles) {
+#ifdef AMREX_AMRDATA_USE_MMAP
+    if(mf.second.addr != nullptr) {
+      munmap(mf.second.addr, mf.second.length);
+    }
+#endif
+  }
+  mappedFiles.clear();
+}
+
+
+// ---------------------------------------------------------------
+void AmrData::ReadRegion(MultiFab &destMultiFab, int level,
+                         const Vector<string> &varNames,
+                         const Vector<int> &destFillComps)
+{
+  BL_PROFILE("AmrData::ReadRegion()");
+  BL_ASSERT(level >= 0 && level <= finestLevel);
+  BL_ASSERT(varNames.size() == destFillComps.size());
+
+  if(fileType == Amrvis::FAB || (fileType == Amrvis::MULTIFAB && level == 0)) {
+    // ---- the data is already in memory
+    for(int n(0); n < varNames.size(); ++n) {
+      destMultiFab.copy(*dataGrids[level][StateNumber(varNames[n])],
+                        0, destFillComps[n], 1);
+    }
+    return;
+  }
+
+  // ---- the parts of the local destination fabs, by the file fab they
+  // ---- come from, so each file fab is read only once
+  const BoxArray &fileBA = boxArray(level);
+  std::map<int, std::vector< std::pair<FArrayBox *, Box> > > regionsByFab;
+  std::vector< std::pair<int,Box> > isects;
+
+  for(MFIter mfi(destMultiFab); mfi.isValid(); ++mfi) {
+    FArrayBox &destFab = destMultiFab[mfi];
+    fileBA.intersections(mfi.validbox(), isects);
+    for(int i(0), N(isects.size()); i < N; ++i) {
+      regionsByFab[isects[i].first].push_back(std::make_pair(&destFab, isects[i].second));
+    }
+  }
+
+  for(int n(0); n < varNames.size(); ++n) {
+    int compIndex(StateNumber(varNames[n]));
+    int whichVisMF(compIndexToVisMFMap[compIndex]);
+    int whichVisMFComponent(compIndexToVisMFComponentMap[compIndex]);
+    int destComp(destFillComps[n]);
+
+    for(const auto &fabRegions : regionsByFab) {
+      int fabIndex(fabRegions.first);
+      Box fabBox;
+      RealDescriptor rd;
+      const char *data = nullptr;
+      if(useMMap) {
+        data = MappedFabData(level, whichVisMF, fabIndex, whichVisMFComponent, fabBox, rd);
+      }
+
+      if(data != nullptr) {
+        // ---- copy one row at a time so only the pages holding
+        // ---- the regions are touched
+        const long nBytes(rd.numBytes());
+        const bool isNative(rd == FPC::NativeRealDescriptor());
+        for(const auto &destRegion : fabRegions.second) {
+          FArrayBox &destFab = *destRegion.first;
+          const Box &region = destRegion.second;
+          const long rowLength(region.length(0));
+          Box rows(region);
+          rows.setBig(0, region.smallEnd(0));
+          for(IntVect iv(rows.smallEnd()); iv <= rows.bigEnd(); rows.next(iv)) {
+            const char *src = data + fabBox.index(iv) * nBytes;
+            Real *dest = destFab.dataPtr(destComp) + destFab.box().index(iv);
+            if(isNative) {
+              std::memcpy(dest, src, rowLength * sizeof(Real));
+            } else {
+              RealDescriptor::convertToNativeFormat(dest, rowLength,
+                                                    const_cast<char *>(src), rd);
+            }
+          }
+        }
+      } else {
+        std::unique_ptr<FArrayBox> fab(visMF[level][whichVisMF]->readFAB(fabIndex,
+                                                             whichVisMFComponent));
+        for(const auto &destRegion : fabRegions.second) {
+          const Box &region = destRegion.second;
+          destRegion.first->copy(*fab, region, 0, region, destComp, 1);
+        }
+      }
+    }
+  }
+}
+
+
 // ---------------------------------------------------------------
 void AmrData::FlushGrids() {
   for (int componentIndex(0); componentIndex < nComp; ++componentIndex) {
@@ -5,10 +5,174 @@
 #include "AMReX_parstream.H"
 #include "AMReX_Print.H"
 
+#include <algorithm>
+#include <cstring>
+
 namespace amrex
 {
   static const IntVect ebg_debiv(AMREX_D_DECL(0, 0, 0));
   bool EBGraphImplem::s_verbose = false;
+  constexpr int EBGraphImplem::s_regularCell;
+  constexpr int EBGraphImplem::s_coveredCell;
+
+  /*******************************/
+  void EBGraphImplem::FlatGraph::define(const Box& a_box, bool a_isRegular)
+  {
+    clear();
+    cells.resize(a_box, 2);
+    if (a_isRegular)
+    {
+      cells.setVal(s_regularCell, 0);
+      cells.setVal(1, 1);
+    }
+    else
+    {
+      cells.setVal(s_coveredCell, 0);
+      cells.setVal(0, 1);
+    }
+  }
+        
+  /*******************************/
+  void EBGraphImplem::FlatGraph::clear()
+  {
+    cells.clear();
+    isRegular.clear();
+    coarser.clear();
+    arcBegin.assign(1, 0);
+    arcs.clear();
+    finerBegin.assign(1, 0);
+    finer.clear();
+    numDead = 0;
+  }
+        
+  /*******************************/
+  void EBGraphImplem::FlatGraph::compact()
+  {
+    BL_PROFILE("EBGraphImplem::FlatGraph::compact");
+    const Box& graphBox = cells.box();
+    const int nlive = numNodes() - numDead;
+
+    FlatGraph newGraph;
+    newGraph.define(graphBox, true);
+    newGraph.isRegular .reserve(nlive);
+    newGraph.coarser   .reserve(nlive);
+    newGraph.arcBegin  .reserve(2*SpaceDim*nlive+1);
+    newGraph.arcs      .reserve(arcs.size());
+    newGraph.finerBegin.reserve(nlive+1);
+    newGraph.finer     .reserve(finer.size());
+    for (BoxIterator bit(graphBox); bit.ok(); ++bit)
+    {
+      newGraph.copyCell(*this, bit());
+    }
+
+    //BaseFab has no move assignment, so copy the (small) cell array
+    //and swap the node arrays
+    cells.copy(newGraph.cells);
+    std::swap(isRegular , newGraph.isRegular);
+    std::swap(coarser   , newGraph.coarser);
+    std::swap(arcBegin  , newGraph.arcBegin);
+    std::swap(arcs      , newGraph.arcs);
+    std::swap(finerBegin, newGraph.finerBegin);
+    std::swap(finer     , newGraph.finer);
+    numDead = 0;
+  }
+        
+  /*******************************/
+  void EBGraphImplem::FlatGraph::addNode(bool a_isRegular, int a_coarser)
+  {
+    isRegular.push_back(a_isRegular);
+    coarser.push_back(a_coarser);
+    for (int iarc = 0; iarc < 2*SpaceDim; iarc++)
+    {
+      arcBegin.push_back(arcs.size());
+    }
+    finerBegin.push_back(finer.size());
+  }
+        
+  /*******************************/
+  void EBGraphImplem::FlatGraph::addNode(bool                        a_isRegular,
+                                         int                         a_coarser,
+                                         const Vector<Vector<int> >& a_arcs,
+                                         const Vector<VolIndex>&     a_finer)
+  {
+    BL_ASSERT(a_arcs.size() == 2*SpaceDim);
+    isRegular.push_back(a_isRegular);
+    coarser.push_back(a_coarser);
+    for (int iarc = 0; iarc < 2*SpaceDim; iarc++)
+    {
+      arcs.insert(arcs.end(), a_arcs[iarc].begin(), a_arcs[iarc].end());
+      arcBegin.push_back(arcs.size());
+    }
+    finer.insert(finer.end(), a_finer.begin(), a_finer.end());
+    finerBegin.push_back(finer.size());
+  }
+        
+  /*******************************/
+  void EBGraphImplem::FlatGraph::addNode(const FlatGraph& a_src, int a_node)
+  {
+    BL_ASSERT(&a_src != this);
+    isRegular.push_back(a_src.isRegular[a_node]);
+    coarser.push_back(a_src.coarser[a_node]);
+    for (int iarc = 0; iarc < 2*SpaceDim; iarc++)
+    {
+      const int* arcp = a_src.arcPtr(a_node, iarc);
+      arcs.insert(arcs.end(), arcp, arcp + a_src.numArcs(a_node, iarc));
+      arcBegin.push_back(arcs.size());
+    }
+    const VolIndex* finep = a_src.finerPtr(a_node);
+    finer.insert(finer.end(), finep, finep + a_src.numFiner(a_node));
+    finerBegin.push_back(finer.size());
+  }
+        
+  /*******************************/
+  void EBGraphImplem::FlatGraph::copyCell(const FlatGraph& a_src, const IntVect& a_iv)
+  {
+    const int srcFirst = a_src.first(a_iv);
+    if (srcFirst < 0)
+    {
+      retire(a_iv);
+      cells(a_iv, 0) = srcFirst;
+      cells(a_iv, 1) = a_src.count(a_iv);
+    }
+    else
+    {
+      const int nvofs = a_src.count(a_iv);
+      beginCell(a_iv, nvofs);
+      for (int ivof = 0; ivof < nvofs; ivof++)
+      {
+        addNode(a_src, srcFirst + ivof);
+      }
+    }
+  }
+        
+  /*******************************/
+  void EBGraphImplem::makeDense()
+  {
+    BL_ASSERT(isAllRegular() || isAllCovered());
+    m_multiIVS = IntVectSet();
+    m_irregIVS = IntVectSet();
+    m_graph.define(m_region, isAllRegular());
+    m_tag = HasIrregular;
+  }
+        
+  /*******************************/
+  void EBGraphImplem::copyCellFrom(const EBGraphImplem& a_src,
+                                   const IntVect&       a_iv,
+                                   FlatGraph&           a_dst)
+  {
+    if (a_src.isAllRegular())
+    {
+      a_dst.setRegular(a_iv);
+    }
+    else if (a_src.isAllCovered())
+    {
+      a_dst.setCovered(a_iv);
+    }
+    else
+    {
+      a_dst.copyCell(a_src.m_graph, a_iv);
+    }
+  }
   /*******************************/
   Vector<FaceIndex> EBGraph::getMultiValuedFaces(const int&  a_idir,
                                                       const Box&  a_box) const
@@ -123,41 +287,41 @@ namespace amrex
       BL_ASSERT(!isAllCovered());
       if (isAllRegular())
       {
-        m_tag = HasIrregular;
-        m_multiIVS = IntVectSet();
-        m_irregIVS = IntVectSet();
-        m_graph.resize(m_region, 1);
-        for (BoxIterator bit(m_region); bit.ok(); ++bit)
-        {
-          m_graph(bit(), 0).defineAsRegular();
-        }
+        makeDense();
       }
         
       //  //now for changing vofs
+      Vector<Vector<int> > nodeArcs(2*SpaceDim);
       for (IVSIterator ivsit(a_vofsToChange); ivsit.ok(); ++ivsit)
       {
         const IntVect&  iv = ivsit();
         //needs to be a regular cell to start with
         BL_ASSERT(isRegular(iv));
+        if (m_graph.first(iv) >= 0)
+        {
+          amrex::Error("that vof was already irregular");
+        }
         VolIndex vof(iv, 0);
         
-        GraphNode regularNode;
-        regularNode.defineAsRegular();
-        
         //create node and its arcs
         //the coarse-fine info is created later.
         //this operation must be done before all that
         //the finer ones can be set trivially but not the
         //coarse ones.
-        GraphNodeImplem node;
-        node.m_finerNodes = regularNode.refine(vof);
+        Vector<VolIndex> finerNodes;
+        Box refbox(iv, iv);
+        refbox.refine(2);
+        for (BoxIterator bit(refbox); bit.ok(); ++bit)
+        {
+          finerNodes.push_back(VolIndex(bit(), 0));
+        }
         for (int idir = 0; idir < SpaceDim; idir++)
         {
           for (SideIterator sit; sit.ok(); ++sit)
           {
         
             int gNodeIndex = IrregNode::index(idir, sit());
-            Vector<int>& nodeArcsDir = node.m_arc[gNodeIndex];
+            Vector<int>& nodeArcsDir = nodeArcs[gNodeIndex];
             nodeArcsDir.resize(0);
             //find which vof node is connected to in each direction.
             //cannot use isConnected here because it will always return
@@ -193,13 +357,11 @@ namespace amrex
         }
         //finally add node into graph.
         //again coarse and fine info have to be added on later.
-        m_graph(iv, 0).addIrregularNode(node);
+        m_graph.beginCell(iv, 1);
+        m_graph.addNode(false, -1, nodeArcs, finerNodes);
         (m_irregIVS) |= iv;
-        if (m_graph(iv, 0).size() > 1)
-        {
-          amrex::Error("that vof was already irregular");
-        }
       }
+      m_graph.compactIfSparse();
     }
   }
         
@@ -233,6 +395,7 @@ namespace amrex
     m_tag = AllRegular;
     m_irregIVS = IntVectSet();
     m_multiIVS = IntVectSet();
+    m_graph.clear();
     EBCellFlag flag;
     flag.setRegular();
     m_cellFlags.setVal(flag);
@@ -247,6 +410,7 @@ namespace amrex
     m_tag = AllCovered;
     m_irregIVS = IntVectSet();
     m_multiIVS = IntVectSet();
+    m_graph.clear();
 
     EBCellFlag flag;
     flag.setCovered();
@@ -424,101 +588,121 @@ namespace amrex
     m_tag = HasIrregular;
     m_multiIVS = IntVectSet();
     m_irregIVS = IntVectSet();
-    m_graph.resize(m_region, 1);
+    m_graph.define(m_region, true);
         
     //set regular and covered cells
     for (BoxIterator bit(m_region); bit.ok(); ++bit)
     {
       const IntVect& iv = bit();
-      if (a_regIrregCovered(iv, 0) == 1) //regular cell
-      {
-        m_graph(iv, 0).defineAsRegular();
-      }
-      else if (a_regIrregCovered(iv, 0) == -1) //covered cell
+      if (a_regIrregCovered(iv, 0) == -1) //covered cell
       {
-        m_graph(iv, 0).defineAsCovered();
+        m_graph.setCovered(iv);
       }
-      else if (a_regIrregCovered(iv, 0) != 0)
+      else if ((a_regIrregCovered(iv, 0) != 1) && (a_regIrregCovered(iv, 0) != 0))
       {
         amrex::Error("invalid flag");
       }
     }
         
-    //now for irregular cells
-    //add the vofs
+    //now for irregular cells.
+    //sort the input so that the vofs of each cell are contiguous
+    //and in cell index order.
+    Vector<int> order(a_irregGraph.size());
     for (int ivecIrreg = 0; ivecIrreg < a_irregGraph.size(); ivecIrreg++)
     {
-      const IrregNode& inputNode = a_irregGraph[ivecIrreg];
-      const IntVect& iv =inputNode.m_cell;
-        
-      GraphNodeImplem newImplem;
-      newImplem.m_nodeInd = ivecIrreg;
-        
-      m_graph(iv, 0).addIrregularNode(newImplem, inputNode.m_cellIndex);
-      (m_irregIVS) |= iv;
-      if (m_graph(iv, 0).size() > 1)
+      order[ivecIrreg] = ivecIrreg;
+    }
+    std::sort(order.begin(), order.end(),
+              [&] (int a_left, int a_right) -> bool
+              {
+                const IrregNode& lnode = a_irregGraph[a_left];
+                const IrregNode& rnode = a_irregGraph[a_right];
+                if (lnode.m_cell != rnode.m_cell)
+                {
+                  return m_region.index(lnode.m_cell) < m_region.index(rnode.m_cell);
+                }
+                return lnode.m_cellIndex < rnode.m_cellIndex;
+              });
+        
+    //add the vofs and their faces
+    Vector<Vector<int> > nodeArcs(2*SpaceDim);
+    Vector<VolIndex> noFinerNodes;
+    int isort = 0;
+    while (isort < order.size())
+    {
+      const IntVect& iv = a_irregGraph[order[isort]].m_cell;
+      int iend = isort;
+      while ((iend < order.size()) && (a_irregGraph[order[iend]].m_cell == iv))
       {
-        (m_multiIVS) |= iv;
+        iend++;
       }
-    }
+      const int nvofs = a_irregGraph[order[iend-1]].m_cellIndex + 1;
+      m_graph.beginCell(iv, nvofs);
         
-    //add the faces
-    for (int ivecIrreg = 0; ivecIrreg < a_irregGraph.size(); ivecIrreg++)
-    {
-      const IrregNode& inputNode = a_irregGraph[ivecIrreg];
-      const IntVect& iv =inputNode.m_cell;
-      Vector<GraphNodeImplem>& vecNodes = *(m_graph(iv, 0).m_cellList);
-      //pick out which node we are talking about
-      //by maching its nodeInd with ivecIrreg
-      bool foundNode = false;
-      GraphNodeImplem* nodePtr = NULL;
-      for (int ivecGraph = 0; ivecGraph < vecNodes.size(); ivecGraph++)
-      {
-        if (vecNodes[ivecGraph].m_nodeInd == ivecIrreg)
+      for (int ivof = 0; ivof < nvofs; ivof++)
+      {
+        if ((isort == iend) || (a_irregGraph[order[isort]].m_cellIndex != ivof))
         {
-          foundNode = true;
-          nodePtr = &(vecNodes[ivecGraph]);
+          if ((isort < iend) && (a_irregGraph[order[isort]].m_cellIndex < ivof))
+          {
+            amrex::Error("EBGraph: internal error in construction");
+          }
+          //a hole in the cell indices gets an empty node
+          m_graph.addNode(false, -1);
+          continue;
         }
-      }
-      if (!foundNode)
-      {
-        amrex::Error("EBGraph: internal error in construction");
-      }
-      //now add the arcs in the input to the node
-      GraphNodeImplem& node = *nodePtr;
-      for (int idir = 0; idir < SpaceDim; idir++)
-      {
-        for (SideIterator sit; sit.ok(); ++sit)
+        
+        //now add the arcs in the input to the node
+        const IrregNode& inputNode = a_irregGraph[order[isort]];
+        for (int idir = 0; idir < SpaceDim; idir++)
         {
-          int irregIndex = IrregNode::index(idir, sit());
-          int gNodeIndex = IrregNode::index(idir, sit());
-          const Vector<int>& irregArcs = inputNode.m_arc[irregIndex];
-          Vector<int>& nodeArcs = node.m_arc[gNodeIndex];
-          nodeArcs.resize(irregArcs.size());
-          for (int iarc = 0; iarc < irregArcs.size(); iarc++)
+          for (SideIterator sit; sit.ok(); ++sit)
           {
-            int otherNodeInd = irregArcs[iarc];
-            if (otherNodeInd == -1)
-            {
-              //if otherNodeInd == -1, boundary arc.
-              //just make the arc in our node = -1
-              //to signify the same
-              nodeArcs[iarc] = -1;
-            }
-            else if (otherNodeInd == -2)
-            {
-              //this means that the vof is connected
-              //to a regular vof,
-              //which always have a cell index of 0
-              nodeArcs[iarc] =  0;
-            }
-            else
+            int irregIndex = IrregNode::index(idir, sit());
+            int gNodeIndex = IrregNode::index(idir, sit());
+            const Vector<int>& irregArcs = inputNode.m_arc[irregIndex];
+            Vector<int>& arcs = nodeArcs[gNodeIndex];
+            arcs.resize(irregArcs.size());
+            for (int iarc = 0; iarc < irregArcs.size(); iarc++)
             {
-              nodeArcs[iarc] =  otherNodeInd;
+              int otherNodeInd = irregArcs[iarc];
+              if (otherNodeInd == -1)
+              {
+                //if otherNodeInd == -1, boundary arc.
+                //just make the arc in our node = -1
+                //to signify the same
+                arcs[iarc] = -1;
+              }
+              else if (otherNodeInd == -2)
+              {
+                //this means that the vof is connected
+                //to a regular vof,
+                //which always have a cell index of 0
+                arcs[iarc] =  0;
+              }
+              else
+              {
+                arcs[iarc] =  otherNodeInd;
+              }
             }
           }
         }
+        m_graph.addNode(false, -1, nodeArcs, noFinerNodes);
+        isort++;
       }
+      isort = iend;
+    }
+        
+    //fill the cell sets in input order, which fixes their layout
+    for (int ivecIrreg = 0; ivecIrreg < a_irregGraph.size(); ivecIrreg++)
+    {
+      const IrregNode& inputNode = a_irregGraph[ivecIrreg];
+      const IntVect& iv =inputNode.m_cell;
+      if ((inputNode.m_cellIndex > 0) || m_irregIVS.contains(iv))
+      {
+        (m_multiIVS) |= iv;
+      }
+      (m_irregIVS) |= iv;
     }
     setCellFlags();
   }
@@ -637,8 +821,12 @@ namespace amrex
     {
       BL_ASSERT(m_region.contains(a_iv));
       BL_ASSERT(m_domain.contains(a_iv));
-      const GraphNode& node = m_graph(a_iv, 0);
-      retvec = node.getVoFs(a_iv);
+      const int nvofs = m_graph.count(a_iv);
+      retvec.resize(nvofs);
+      for (int ivof = 0; ivof < nvofs; ivof++)
+      {
+        retvec[ivof] = VolIndex(a_iv, ivof);
+      }
     }
     return retvec;
   }
@@ -665,8 +853,7 @@ namespace amrex
     {
       //BL_ASSERT(m_region.contains(a_iv)); //picked up my m_graph already
       //BL_ASSERT(m_domain.contains(a_iv));
-      const GraphNode& node = m_graph(a_iv, 0);
-      retval = node.isRegular();
+      retval = m_graph.isRegularCell(a_iv);
     }
     else
     {
@@ -717,8 +904,7 @@ namespace amrex
     {
       BL_ASSERT(m_region.contains(a_iv));
       BL_ASSERT(m_domain.contains(a_iv));
-      const GraphNode& node = m_graph(a_iv, 0);
-      retval = node.isIrregular();
+      retval = (!m_graph.isRegularCell(a_iv) && !m_graph.isCoveredCell(a_iv));
     }
     else
     {
@@ -772,8 +958,7 @@ namespace amrex
     {
       //BL_ASSERT(m_region.contains(a_iv)); this check picked up by m_graph
       //BL_ASSERT(m_domain.contains(a_iv));
-      const GraphNode& node = m_graph(a_iv, 0);
-      retval = node.isCovered();
+      retval = m_graph.isCoveredCell(a_iv);
     }
     else
     {
@@ -894,8 +1079,31 @@ namespace amrex
     else if (m_tag == HasIrregular)
     {
       const IntVect& iv = a_vof.gridIndex();
-      const GraphNode& node = m_graph(iv, 0);
-      retvec = node.getFaces(a_vof, a_idir, a_sd, m_domain);
+      IntVect otherIV = iv + sign(a_sd)*BASISV(a_idir);
+      if (m_graph.isRegularCell(iv))
+      {
+        // if node is regular, the other iv must be single valued
+        int otherCellInd = 0;
+        if (!m_domain.contains(otherIV))
+        {
+          otherCellInd = -1;
+        }
+        VolIndex otherVoF(otherIV, otherCellInd);
+        retvec.push_back(FaceIndex(a_vof, otherVoF, a_idir));
+      }
+      else if (!m_graph.isCoveredCell(iv))
+      {
+        const int inode = m_graph.first(iv) + a_vof.cellIndex();
+        const int index = IrregNode::index(a_idir, a_sd);
+        const int* arcs = m_graph.arcPtr(inode, index);
+        const int narcs = m_graph.numArcs(inode, index);
+        retvec.resize(narcs);
+        for (int iarc = 0; iarc < narcs; iarc++)
+        {
+          VolIndex otherVoF(otherIV, arcs[iarc]);
+          retvec[iarc].define(a_vof, otherVoF, a_idir);
+        }
+      }
     }
         
     return retvec;
@@ -999,7 +1207,7 @@ namespace amrex
       }
       else
       {
-        Box b = a_mask.box() & m_graph.box();
+        Box b = a_mask.box() & m_graph.cells.box();
         if (b.isEmpty()) return;
         for (BoxIterator bit(b); bit.ok(); ++bit)
         {
@@ -1183,8 +1391,13 @@ namespace amrex
     {
       BL_ASSERT(m_tag == HasIrregular);
       const IntVect& iv = a_fineVoF.gridIndex();
-      const GraphNode& node = m_graph(iv, 0);
-      retval = node.coarsen(a_fineVoF);
+      const int inode = m_graph.first(iv);
+      int cellIndexCoar = 0;
+      if (inode >= 0)
+      {
+        cellIndexCoar = m_graph.coarser[inode + a_fineVoF.cellIndex()];
+      }
+      retval = VolIndex(ivcoar, cellIndexCoar);
     }
     return retval;
   }
@@ -1220,8 +1433,21 @@ namespace amrex
     {
       BL_ASSERT(m_tag == HasIrregular);
       const IntVect& iv = a_coarVoF.gridIndex();
-      const GraphNode& node = m_graph(iv, 0);
-      retval = node.refine(a_coarVoF);
+      if (m_graph.isRegularCell(iv))
+      {
+        Box refbox(iv,iv);
+        refbox.refine(2);
+        for (BoxIterator bit(refbox); bit.ok(); ++bit)
+        {
+          retval.push_back(VolIndex(bit(), 0));
+        }
+      }
+      else if (!m_graph.isCoveredCell(iv))
+      {
+        const int inode = m_graph.first(iv) + a_coarVoF.cellIndex();
+        const VolIndex* finer = m_graph.finerPtr(inode);
+        retval.assign(finer, finer + m_graph.numFiner(inode));
+      }
     }
     return retval;
   }
@@ -1266,93 +1492,46 @@ namespace amrex
       }
       else if (isAllRegular() && a_source.isAllCovered())
       {
-        //define the basefab as all regular and set the region to
+        //define the graph as all regular and set the region to
         //covered in the intersection
-        m_tag = HasIrregular;
-        m_multiIVS = IntVectSet();
-        m_irregIVS = IntVectSet();
-        m_graph.resize(m_region, 1);
-        GraphNode regularNode;
-        regularNode.defineAsRegular();
-        m_graph.setVal(regularNode);
+        makeDense();
         Box interBox = m_region & regionTo;
         for (BoxIterator bit(interBox); bit.ok(); ++bit)
         {
-          m_graph(bit(), 0).defineAsCovered();
+          m_graph.setCovered(bit());
         }
       }
       else if (isAllCovered() && a_source.isAllRegular())
       {
-        //define the basefab as all covered and set the region to
+        //define the graph as all covered and set the region to
         //regular in the intersection
-        m_tag = HasIrregular;
-        m_multiIVS = IntVectSet();
-        m_irregIVS = IntVectSet();
-        m_graph.resize(m_region, 1);
-        GraphNode  coveredNode;
-        coveredNode.defineAsCovered();
-        m_graph.setVal(coveredNode);
+        makeDense();
         Box interBox = m_region & regionTo;
         for (BoxIterator bit(interBox); bit.ok(); ++bit)
         {
-          m_graph(bit(), 0).defineAsRegular();
+          m_graph.setRegular(bit());
         }
       }
       else
       {
         //one or both has irregular cells.
-        //because i am sick of combinatorics,
-        //use basefab copy to transfer the data.
-        
-        //see if we need to generate a source fab
-
-        BaseFab<GraphNode>* srcFabPtr;
-        std::unique_ptr<BaseFab<GraphNode> > raii;
-        if (a_source.hasIrregular())
-        {
-          srcFabPtr = (BaseFab<GraphNode>*)&a_source.m_graph;
-        }
-        else
-        {
-          raii.reset(new BaseFab<GraphNode>(regionFrom, 1));
-          srcFabPtr = raii.get();
-          GraphNode srcVal;
-          if (a_source.isAllRegular())
-          {
-            srcVal.defineAsRegular();
-          }
-          else
-          {
-            //this really has to be true
-            BL_ASSERT(a_source.isAllCovered());
-            srcVal.defineAsCovered();
-          }
-          srcFabPtr->setVal(srcVal);
-        }
         //define our graph if i need to. leave alone otherwise
         if (isAllRegular() || isAllCovered())
         {
-          m_multiIVS = IntVectSet();
-          m_irregIVS = IntVectSet();
-          m_graph.resize(m_region, 1);
-        }
-        //these conditionals only depend on m_tag
-        if (isAllRegular())
-        {
-          GraphNode regularNode;
-          regularNode.defineAsRegular();
-          m_graph.setVal(regularNode);
+          makeDense();
         }
-        else if(isAllCovered())
+
+        //copy the cells one at a time.  nodes of overwritten cells
+        //are left behind until there are enough of them to compact.
+        if (&a_source != this)
         {
-          GraphNode  coveredNode;
-          coveredNode.defineAsCovered();
-          m_graph.setVal(coveredNode);
+          const Box copyBox = regionTo & m_region;
+          for (BoxIterator bit(copyBox); bit.ok(); ++bit)
+          {
+            copyCellFrom(a_source, bit(), m_graph);
+          }
+          m_graph.compactIfSparse();
         }
-        //copy the data and set the tag properly
-        m_tag = HasIrregular;
-
-        m_graph.copy(*srcFabPtr, regionFrom, 0,regionTo, 0, 1);
         
         //  now fix up the IntVectSets to match the information
         if (a_source.hasIrregular())
@@ -1449,7 +1628,7 @@ namespace amrex
       m_tag = HasIrregular;
       m_multiIVS = IntVectSet();
       m_irregIVS = IntVectSet();
-      m_graph.resize(m_region, 1);
+      m_graph.define(m_region, true);
       for (BoxIterator bit(a_coarRegion); bit.ok(); ++bit)
       {
         const IntVect& iv = bit();
@@ -1458,11 +1637,11 @@ namespace amrex
 
         if (a_fineGraph.isRegular(fineBox))
         {
-          m_graph(bit(), 0).defineAsRegular();
+          m_graph.setRegular(iv);
         }
         else if (a_fineGraph.isCovered(fineBox))
         {
-          m_graph(bit(), 0).defineAsCovered();
+          m_graph.setCovered(iv);
         }
         else
         {
@@ -1473,17 +1652,16 @@ namespace amrex
           const Vector<Vector<VolIndex> >& fineVoFSets
             = a_fineGraph.getVoFSets(fineBox);
         
+          const Vector<Vector<int> > noArcs(2*SpaceDim);
+          m_graph.beginCell(iv, fineVoFSets.size());
           for (int iset = 0; iset < fineVoFSets.size(); iset++)
           {
-            GraphNodeImplem newImplem;
-            newImplem.m_finerNodes = fineVoFSets[iset];
-
-            m_graph(bit(), 0).addIrregularNode(newImplem);
-            (m_irregIVS) |= bit();
-            if (m_graph(bit(), 0).size() > 1)
-            {
-              (m_multiIVS) |= bit();
-            }
+            m_graph.addNode(false, -1, noArcs, fineVoFSets[iset]);
+          }
+          (m_irregIVS) |= iv;
+          if (fineVoFSets.size() > 1)
+          {
+            (m_multiIVS) |= iv;
           }
         }
       }
@@ -1651,33 +1829,45 @@ namespace amrex
     {
       Box region = m_region;
       region &= a_coarRegion;
+      //arcs change size, so each irregular cell is appended anew
+      //with its old coarse-fine information and then the
+      //superseded nodes are compacted away.
+      Vector<Vector<Vector<int> > > cellArcs;
+      Vector<VolIndex> finerNodes;
       for (BoxIterator bit(region); bit.ok(); ++bit)
       {
         if (isIrregular(bit()))
         {
           const Vector<VolIndex>& vofsCoar = getVoFs(bit());
-          Vector<GraphNodeImplem>& nodes =
-            *(m_graph(bit(), 0).m_cellList);
+          cellArcs.resize(vofsCoar.size(), Vector<Vector<int> >(2*SpaceDim));
           for (int ivof = 0; ivof < vofsCoar.size(); ivof++)
           {
-            const VolIndex& vofCoar= vofsCoar[ivof];
-            GraphNodeImplem& node = nodes[vofCoar.cellIndex()];
             for (int idir = 0; idir < SpaceDim; idir++)
             {
               for (SideIterator sit; sit.ok(); ++sit)
               {
-                const Vector<int>&& coarArcs =
+                int nodeind = IrregNode::index(idir, sit());
+                cellArcs[ivof][nodeind] =
                   coarsenFaces(vofsCoar[ivof],
                                a_fineGraph,
                                idir, sit());
-        
-                int nodeind = IrregNode::index(idir, sit());
-                node.m_arc[nodeind] = coarArcs;
               }
             }
           }
+
+          const int oldFirst = m_graph.first(bit());
+          m_graph.beginCell(bit(), vofsCoar.size());
+          for (int ivof = 0; ivof < vofsCoar.size(); ivof++)
+          {
+            const int oldNode = oldFirst + vofsCoar[ivof].cellIndex();
+            const VolIndex* finer = m_graph.finerPtr(oldNode);
+            finerNodes.assign(finer, finer + m_graph.numFiner(oldNode));
+            m_graph.addNode(m_graph.isRegular[oldNode], m_graph.coarser[oldNode],
+                            cellArcs[ivof], finerNodes);
+          }
         }
       }
+      m_graph.compactIfSparse();
     }
     setCellFlags();
   }
@@ -1693,10 +1883,7 @@ namespace amrex
         {
           const IntVect& ivCoar = bit();
         
-          const Vector<GraphNodeImplem>&
-            vofsCoar = *(m_graph(ivCoar, 0).m_cellList);
-        
-          int numVofsCoar = vofsCoar.size();
+          int numVofsCoar = m_graph.count(ivCoar);
         
           for (int icoar = 0; icoar < numVofsCoar; icoar++)
           {
@@ -1711,24 +1898,28 @@ namespace amrex
               {
                 int cellIndexFine = vofsFine[ifine].cellIndex();
         
-                Vector<GraphNodeImplem>&
-                  nodesFine = *(a_fineGraph.m_graph(ivFine, 0).m_cellList);
-        
-                nodesFine[cellIndexFine].m_coarserNode = icoar;
+                FlatGraph& graphFine = a_fineGraph.m_graph;
+                graphFine.coarser[graphFine.first(ivFine) + cellIndexFine] = icoar;
               }
               else if ((numVofsCoar > 1) && (a_fineGraph.isRegular(ivFine)))
               {
-                GraphNode& nodeFine = a_fineGraph.m_graph(ivFine, 0);
-        
-                nodeFine.m_cellList = new Vector<GraphNodeImplem>(1);
-        
-                (*(nodeFine.m_cellList))[0].m_isRegular   = true;
-                (*(nodeFine.m_cellList))[0].m_coarserNode = icoar;
+                if (a_fineGraph.isAllRegular())
+                {
+                  a_fineGraph.makeDense();
+                }
+                //regular cell with a multi-valued parent
+                FlatGraph& graphFine = a_fineGraph.m_graph;
+                graphFine.beginCell(ivFine, 1);
+                graphFine.addNode(true, icoar);
               }
             }
           }
         }
       }
+      if (a_fineGraph.hasIrregular())
+      {
+        a_fineGraph.m_graph.compactIfSparse();
+      }
     }
   }
         
@@ -1786,11 +1977,9 @@ namespace amrex
     retval +=  4*Box::linearSize();
     if(m_tag == HasIrregular)
     {
-      for (BoxIterator bit(m_graph.box()); bit.ok(); ++bit)
+      for (BoxIterator bit(m_graph.cells.box()); bit.ok(); ++bit)
       {
-        const GraphNode& node = m_graph(bit(), 0);
-        int nodeSize = node.linearSize();
-        retval += nodeSize;
+        retval += cellLinearSize(bit());
       }
       retval += m_irregIVS.linearSize();
       retval += m_multiIVS.linearSize();
@@ -1830,28 +2019,19 @@ namespace amrex
     buf    += incrval;
     retval += incrval;
 
-    Box graphbox = m_graph.box();
+    Box graphbox = m_graph.cells.box();
     graphbox.linearOut(buf);
-    incrval = m_graph.box().linearSize();
+    incrval = graphbox.linearSize();
     buf    += incrval;
     retval += incrval;
 
     if(m_tag == HasIrregular)
     {
-      for (BoxIterator bit(m_graph.box()); bit.ok(); ++bit)
-      {
-        //IntVect ivdeb(AMREX_D_DECL(10, 7, 0));
-        //int ideb = 0;
-        //if(bit() == ivdeb)
-        //{
-        //  ideb = 1;
-        //}
-        const GraphNode& node = m_graph(bit(), 0);
-        node.linearOut(buf);
-        incrval = node.linearSize();
+      for (BoxIterator bit(graphbox); bit.ok(); ++bit)
+      {
+        incrval = cellLinearOut(bit(), buf);
         buf    += incrval;
         retval += incrval;
-
       }
       m_irregIVS.linearOut(buf);
       incrval =  m_irregIVS.linearSize();
@@ -1900,27 +2080,18 @@ namespace amrex
 
     Box graphbox;
     graphbox.linearIn(buf);
-    incrval = m_graph.box().linearSize();
+    incrval = graphbox.linearSize();
     buf    += incrval;
     retval += incrval;
 
     if(m_tag == HasIrregular)
     {
-      m_graph.resize(graphbox, 1);
-      for (BoxIterator bit(m_graph.box()); bit.ok(); ++bit)
-      {
-        //IntVect ivdeb(AMREX_D_DECL(10, 7, 0));
-        //int ideb = 0;
-        //if(bit() == ivdeb)
-        //{
-        //  ideb = 1;
-        //}
-        GraphNode& node = m_graph(bit(), 0);
-        node.linearIn(buf);
-        incrval = node.linearSize();
+      m_graph.define(graphbox, true);
+      for (BoxIterator bit(graphbox); bit.ok(); ++bit)
+      {
+        incrval = cellLinearIn(m_graph, bit(), buf);
         buf    += incrval;
         retval += incrval;
-
       }
       m_irregIVS.linearIn(buf);
       incrval =  m_irregIVS.linearSize();
@@ -1932,6 +2103,10 @@ namespace amrex
       buf    += incrval;
       retval += incrval;
     }
+    else
+    {
+      m_graph.clear();
+    }
 
     m_isDefined   = true;
     m_isDomainSet = true;
@@ -1944,24 +2119,121 @@ namespace amrex
   }
   /*******************************/
 
-  GraphNode
+  //the cell layout is that of the former per-cell GraphNode:
+  //  code (1 regular, 0 covered, 2 nodes follow), number of vofs,
+  //  then per node: isRegular, isValid, 2*SpaceDim arc lists (size, values),
+  //  coarser node, number of finer vofs, finer vofs.
+  std::size_t
   EBGraphImplem::
-  getGraphNode(const IntVect& a_iv) const
+  cellLinearSize(const IntVect& a_iv) const
+  {
+    if (isAllRegular() || isAllCovered() || (m_graph.first(a_iv) < 0))
+    {
+      return sizeof(int);
+    }
+    const int nvofs  = m_graph.count(a_iv);
+    const int inode0 = m_graph.first(a_iv);
+    const int inode1 = inode0 + nvofs;
+    const int narcs  = (m_graph.arcBegin [2*SpaceDim*inode1] -
+                        m_graph.arcBegin [2*SpaceDim*inode0]);
+    const int nfiner = (m_graph.finerBegin[inode1] -
+                        m_graph.finerBegin[inode0]);
+    //code and nvofs, then isRegular, isValid, arc sizes, coarser and
+    //number of finer vofs per node
+    std::size_t retval = sizeof(int)*(2 + nvofs*(4 + 2*SpaceDim));
+    retval += sizeof(int)*narcs;
+    retval += sizeof(int)*(SpaceDim+1)*nfiner;
+    return retval;
+  }
+  /*******************************/
+  std::size_t
+  EBGraphImplem::
+  cellLinearOut(const IntVect& a_iv, unsigned char* a_buf) const
   {
-    GraphNode retval;
-    if(isAllRegular())
+    int* intbuf = (int*) a_buf;
+    if (isAllRegular() || (!isAllCovered() && (m_graph.first(a_iv) == s_regularCell)))
     {
-      retval.defineAsRegular();
+      *intbuf = 1;
+      return sizeof(int);
     }
-    else if(isAllCovered())
+    else if (isAllCovered() || (m_graph.first(a_iv) == s_coveredCell))
     {
-      retval.defineAsCovered();
+      *intbuf = 0;
+      return sizeof(int);
+    }
+
+    const int nvofs  = m_graph.count(a_iv);
+    const int inode0 = m_graph.first(a_iv);
+    *intbuf++ = 2;
+    *intbuf++ = nvofs;
+    for (int inode = inode0; inode < inode0 + nvofs; inode++)
+    {
+      *intbuf++ = m_graph.isRegular[inode];
+      *intbuf++ = 1; //isValid
+      for (int iarc = 0; iarc < 2*SpaceDim; iarc++)
+      {
+        const int narcs = m_graph.numArcs(inode, iarc);
+        *intbuf++ = narcs;
+        std::memcpy(intbuf, m_graph.arcPtr(inode, iarc), narcs*sizeof(int));
+        intbuf += narcs;
+      }
+      *intbuf++ = m_graph.coarser[inode];
+      const int nfiner = m_graph.numFiner(inode);
+      *intbuf++ = nfiner;
+      const VolIndex* finer = m_graph.finerPtr(inode);
+      for (int ifine = 0; ifine < nfiner; ifine++)
+      {
+        finer[ifine].linearOut(intbuf);
+        intbuf += SpaceDim+1;
+      }
+    }
+    return ((unsigned char*) intbuf) - a_buf;
+  }
+  /*******************************/
+  std::size_t
+  EBGraphImplem::
+  cellLinearIn(FlatGraph&           a_graph,
+               const IntVect&       a_iv,
+               const unsigned char* a_buf)
+  {
+    const int* intbuf = (const int*) a_buf;
+    const int secretCode = *intbuf++;
+    if (secretCode == 1)
+    {
+      a_graph.setRegular(a_iv);
+    }
+    else if (secretCode == 0)
+    {
+      a_graph.setCovered(a_iv);
     }
     else
     {
-      retval = m_graph(a_iv, 0);
+      const int nvofs = *intbuf++;
+      a_graph.beginCell(a_iv, nvofs);
+      for (int ivof = 0; ivof < nvofs; ivof++)
+      {
+        a_graph.isRegular.push_back(*intbuf++);
+        intbuf++; //isValid
+        for (int iarc = 0; iarc < 2*SpaceDim; iarc++)
+        {
+          const int narcs = *intbuf++;
+          a_graph.arcs.insert(a_graph.arcs.end(), intbuf, intbuf + narcs);
+          a_graph.arcBegin.push_back(a_graph.arcs.size());
+          intbuf += narcs;
+        }
+        a_graph.coarser.push_back(*intbuf++);
+        const int nfiner = *intbuf++;
+        for (int ifine = 0; ifine < nfiner; ifine++)
+        {
+          VolIndex vof;
+          vof.linearIn(intbuf);
+          a_graph.finer.push_back(vof);
+          intbuf += SpaceDim+1;
+        }
+        a_graph.finerBegin.push_back(a_graph.finer.size());
+      }
     }
-    return retval;
+    return ((const unsigned char*) intbuf) - a_buf;
   }
   /*******************************/
   std::size_t 
@@ -1982,9 +2254,7 @@ namespace amrex
     {
       for (BoxIterator bit(a_region); bit.ok(); ++bit)
       {
-        const GraphNode& node = getGraphNode(bit());
-        size_t nodeSize = node.linearSize();
-        linearSize += nodeSize;
+        linearSize += cellLinearSize(bit());
       }
     }
 
@@ -2036,9 +2306,7 @@ namespace amrex
     {
       for (BoxIterator bit(a_region); bit.ok(); ++bit)
       {
-        const GraphNode& node = getGraphNode(bit());
-        size_t nodeSize = node.linearSize();
-        node.linearOut(buffer);
+        size_t nodeSize = cellLinearOut(bit(), buffer);
         buffer += nodeSize;
         retval += nodeSize;
       }
@@ -2103,52 +2371,34 @@ namespace amrex
     //to get to this point, something is going to have to change in this object
     if (isAllRegular() || isAllCovered())
     {
-      m_multiIVS = IntVectSet();
-      m_irregIVS = IntVectSet();
-      m_graph.resize(m_region, 1);
-      if(isAllRegular())
-      {
-        GraphNode regularNode;
-        regularNode.defineAsRegular();
-        m_graph.setVal(regularNode);
-      }
-      if(isAllCovered())
-      {
-        GraphNode coveredNode;
-        coveredNode.defineAsCovered();
-        m_graph.setVal(coveredNode);
-      }
-      m_tag = HasIrregular;
+      makeDense();
     }
     for (BoxIterator bit(a_region); bit.ok(); ++bit)
     {
-
-      GraphNode& node = m_graph(bit(), 0);
       if(allRegInput)
       {
-        node.defineAsRegular();
+        m_graph.setRegular(bit());
       }
       else if(allCovInput)
       {
-        node.defineAsCovered();
+        m_graph.setCovered(bit());
       }
       else
       {
-        node.linearIn(buffer);
-        if (node.isIrregular())
+        size_t nodeSize = cellLinearIn(m_graph, bit(), buffer);
+        if (isIrregular(bit()))
         {
           (m_irregIVS)|=bit();
         }
-        if (node.size()>1)
+        if (m_graph.count(bit())>1)
         {
           (m_multiIVS)|=bit();
         }
-        size_t nodeSize = node.linearSize();
         buffer += nodeSize;
         retval += nodeSize;
       }
     }
-
+    m_graph.compactIfSparse();
 
     fixCellFlagType();
 
@@ -121,13 +121,16 @@ namespace amrex
     string graphdirname = a_dirname + "/_graph";
     string  datadirname = a_dirname + "/_data";
 
-    FabArrayIO<EBGraph>::read(m_graph, graphdirname);
-    FabArrayIO<EBData >::read(m_data ,  datadirname);
+    m_dm.define(m_grids);
+    FabArrayIO<EBGraph>::read(m_graph, graphdirname, &m_dm);
+    FabArrayIO<EBData >::read(m_data ,  datadirname, &m_dm);
   }
   void 
   EBISLevel::
   writeHeader(const string& a_dirname) const
   {
+    if(!ParallelDescriptor::IOProcessor()) return;
+
     std::ofstream headerfile;
     string filename = a_dirname + string("/headerfile");
     headerfile.open(filename.c_str(), std::ios::out | std::ios::trunc);
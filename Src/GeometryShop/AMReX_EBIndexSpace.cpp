@@ -9,13 +9,35 @@
 #include "AMReX_Utility.H"
 #include "AMReX_Utility.H"
 #include "AMReX_FabArrayIO.H"
+#include "AMReX_ParmParse.H"
+#include "AMReX_STLIF.H"
 #include <string>
 #include <iostream>
+#include <iomanip>
 #include <sstream>
 #include <algorithm>
+#include <typeinfo>
+#include <cstring>
 
 namespace amrex
 {
+  //64 bit FNV-1a, used for the geometry cache key
+  static void ebis_hashBytes(unsigned long long& a_hash, const void* a_bytes, size_t a_nbytes)
+  {
+    const unsigned char* bytes = static_cast<const unsigned char*>(a_bytes);
+    for(size_t ibyte = 0; ibyte < a_nbytes; ibyte++)
+    {
+      a_hash ^= bytes[ibyte];
+      a_hash *= 1099511628211ULL;
+    }
+  }
+
+  template <class T>
+  static void ebis_hashValue(unsigned long long& a_hash, const T& a_val)
+  {
+    ebis_hashBytes(a_hash, &a_val, sizeof(T));
+  }
+
   void 
   EBIndexSpace::
   getFinestLevelWithMultivaluedCells(Box& a_domain, int& a_levelNumber) const
@@ -57,6 +79,14 @@ namespace amrex
   {
     //this creates the directory of all the stuff
     UtilCreateCleanDirectory(a_dirname, true);
+    writeLevels(a_dirname);
+  }
+
+  ///
+  void 
+  EBIndexSpace::
+  writeLevels(const string& a_dirname) const
+  {
     writeHeader(a_dirname);
     for(int ilev = 0; ilev < m_nlevels; ilev++)
     {
@@ -88,11 +118,183 @@ namespace amrex
     amrex::Print() << "leaving EBIS::read" << endl;
   }
 
+  ///
+  string
+  EBIndexSpace::
+  cacheKey(const Box             & a_domain,
+           const RealVect        & a_origin,
+           const Real            & a_dx,
+           const GeometryService & a_geoserver,
+           int                     a_nCellMax,
+           int                     a_maxCoarsenings)
+  {
+    BL_PROFILE("EBIndexSpace::cacheKey");
+    ParmParse pp("ebis");
+    string tag;
+    pp.query("cache_tag", tag);
+
+    bool hasIF = a_geoserver.hasImplicitFunction();
+    if(!hasIF && tag.empty())
+    {
+      amrex::Abort("EBIndexSpace: ebis.cache_dir is set but the geometry service has no implicit function; set ebis.cache_tag to a string that identifies the geometry");
+    }
+
+    unsigned long long hash = 14695981039346656037ULL;
+    ebis_hashValue(hash, s_cacheVersion);
+    ebis_hashValue(hash, int(SpaceDim));
+    ebis_hashValue(hash, int(sizeof(Real)));
+    for(int idir = 0; idir < SpaceDim; idir++)
+    {
+      ebis_hashValue(hash, a_domain.smallEnd(idir));
+      ebis_hashValue(hash, a_domain.bigEnd(idir));
+      ebis_hashValue(hash, a_origin[idir]);
+    }
+    ebis_hashValue(hash, a_dx);
+    ebis_hashValue(hash, a_nCellMax);
+    ebis_hashValue(hash, a_maxCoarsenings);
+    string servname = typeid(a_geoserver).name();
+    ebis_hashBytes(hash, servname.data(), servname.size());
+    ebis_hashBytes(hash, tag.data(), tag.size());
+
+    std::shared_ptr<const BaseIF> implicitFunction;
+    if(hasIF)
+    {
+      implicitFunction = a_geoserver.getImplicitFunction();
+    }
+
+    //an STLIF that walks the cells with its explorer has no value
+    //function, so it is fingerprinted by the bytes of its file.
+    const STLIF* stlIF = dynamic_cast<const STLIF*>(implicitFunction.get());
+    if((stlIF != nullptr) && stlIF->useExplorer())
+    {
+      ebis_hashValue(hash, int(stlIF->getDataType()));
+      unsigned long long fhash = 14695981039346656037ULL;
+      int readable = 1;
+      if(ParallelDescriptor::IOProcessor())
+      {
+        std::ifstream stlfile(stlIF->getFilename().c_str(), std::ios::in | std::ios::binary);
+        readable = stlfile.good() ? 1 : 0;
+        Vector<char> chunk(1 << 20);
+        while(stlfile)
+        {
+          stlfile.read(chunk.dataPtr(), chunk.size());
+          ebis_hashBytes(fhash, chunk.dataPtr(), stlfile.gcount());
+        }
+      }
+      ParallelDescriptor::Bcast(&readable, 1, ParallelDescriptor::IOProcessorNumber());
+      if(readable == 0)
+      {
+        amrex::Abort("EBIndexSpace: cannot read the STL file " + stlIF->getFilename() + " for the geometry cache key");
+      }
+      long lhash;
+      std::memcpy(&lhash, &fhash, sizeof(long));
+      ParallelDescriptor::Bcast(&lhash, 1, ParallelDescriptor::IOProcessorNumber());
+      ebis_hashValue(hash, lhash);
+    }
+    else if(hasIF)
+    {
+      //the IF tree cannot be serialized, so fingerprint it by its values
+      //at every node of the domain, i.e. at the corners of every finest
+      //cell.  the planes of nodes normal to the last direction are dealt
+      //out to the procs, each hashed by itself, and the plane hashes are
+      //hashed in order, so the key does not depend on the number of procs.
+      const Box nodeBox = amrex::surroundingNodes(a_domain);
+      const int lastDir = SpaceDim-1;
+      const int nplanes = nodeBox.length(lastDir);
+      const int nprocs  = ParallelDescriptor::NProcs();
+      const int myproc  = ParallelDescriptor::MyProc();
+      Vector<long> planeHash(nplanes, 0);
+      for(int iplane = myproc; iplane < nplanes; iplane += nprocs)
+      {
+        Box planeBox = nodeBox;
+        planeBox.setSmall(lastDir, nodeBox.smallEnd(lastDir) + iplane);
+        planeBox.setBig  (lastDir, nodeBox.smallEnd(lastDir) + iplane);
+        unsigned long long phash = 14695981039346656037ULL;
+        for(BoxIterator bit(planeBox); bit.ok(); ++bit)
+        {
+          RealVect loc;
+          for(int idir = 0; idir < SpaceDim; idir++)
+          {
+            loc[idir] = a_origin[idir] + a_dx*bit()[idir];
+          }
+          Real value = implicitFunction->value(loc);
+          ebis_hashValue(phash, value);
+        }
+        std::memcpy(&planeHash[iplane], &phash, sizeof(long));
+      }
+      //only the owner has a nonzero entry, so the sum is exact
+      ParallelDescriptor::ReduceLongSum(planeHash.dataPtr(), nplanes);
+      ebis_hashBytes(hash, planeHash.dataPtr(), nplanes*sizeof(long));
+    }
+
+    std::ostringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return key.str();
+  }
+
+  ///
+  bool
+  EBIndexSpace::
+  readCache(const string& a_dirname, const string& a_key)
+  {
+    BL_PROFILE("EBIndexSpace::readCache");
+    int valid = 0;
+    if(ParallelDescriptor::IOProcessor())
+    {
+      std::ifstream keyfile;
+      string filename = a_dirname + string("/cachekey");
+      keyfile.open(filename.c_str(), std::ios::in);
+      int version = -1;
+      string key;
+      if(keyfile >> version >> key)
+      {
+        valid = ((version == s_cacheVersion) && (key == a_key)) ? 1 : 0;
+      }
+    }
+    ParallelDescriptor::Bcast(&valid, 1, ParallelDescriptor::IOProcessorNumber());
+    if(valid == 0)
+    {
+      amrex::Print() << "EBIndexSpace: no valid geometry cache in " << a_dirname << endl;
+      return false;
+    }
+
+    read(a_dirname);
+    return true;
+  }
+
+  ///
+  void
+  EBIndexSpace::
+  writeCache(const string& a_dirname, const string& a_key) const
+  {
+    BL_PROFILE("EBIndexSpace::writeCache");
+    amrex::Print() << "EBIndexSpace: writing geometry cache to " << a_dirname << endl;
+    //a stale cache is of no use to anyone, so no .old copies
+    UtilCreateDirectoryDestructive(a_dirname, true);
+    writeLevels(a_dirname);
+
+    //the key goes in last so that an interrupted write is never read back
+    ParallelDescriptor::Barrier("EBIndexSpace::writeCache");
+    if(ParallelDescriptor::IOProcessor())
+    {
+      std::ofstream keyfile;
+      string filename = a_dirname + string("/cachekey");
+      keyfile.open(filename.c_str(), std::ios::out | std::ios::trunc);
+      keyfile << s_cacheVersion << endl;
+      keyfile << a_key << endl;
+      keyfile.flush();
+      keyfile.close();
+    }
+    ParallelDescriptor::Barrier("EBIndexSpace::writeCache");
+  }
+
   ///
   void 
   EBIndexSpace::
   writeHeader(const string& a_dirname) const
   {
+    if(!ParallelDescriptor::IOProcessor()) return;
+
     std::ofstream headerfile;
     string filename = a_dirname + string("/headerfile");
     headerfile.open(filename.c_str(), std::ios::out | std::ios::trunc);
@@ -166,6 +368,21 @@ namespace amrex
     {
       m_implicitFunction = a_geoserver.getImplicitFunction();
     }
+
+    ParmParse pp("ebis");
+    string cacheDir;
+    pp.query("cache_dir", cacheDir);
+    string key;
+    if(!cacheDir.empty())
+    {
+      key = cacheKey(a_domain, a_origin, a_dx, a_geoserver, a_nCellMax, a_maxCoarsenings);
+      if(readCache(cacheDir, key))
+      {
+        amrex::Print() << "leaving EBIS::define (from cache)" << endl;
+        return;
+      }
+    }
+
     //this computes how many levels
     buildFirstLevel(a_domain, a_origin, a_dx, a_geoserver, a_nCellMax, a_maxCoarsenings);
 
@@ -175,6 +392,11 @@ namespace amrex
       amrex::Print() << "  Building level " << ilev << "..." << endl;
       buildNextLevel(a_geoserver, ilev);
     }
+
+    if(!key.empty())
+    {
+      writeCache(cacheDir, key);
+    }
     amrex::Print() << "leaving EBIS::define" << endl;
   }
   ///
@@ -5,12 +5,19 @@
 
 namespace amrex
 {
+  string
+  FAIOElement::
+  getFilePrefix()
+  {
+    return string("data_");
+  }
+
+  ///
   string
   FAIOElement::
   getFilename(const int& a_fileid)
   {
-    string retval = string("data_") + EBArith::convertInt(a_fileid);
-    return retval;
+    return NFilesIter::FileName(a_fileid, getFilePrefix());
   }
 
   ///
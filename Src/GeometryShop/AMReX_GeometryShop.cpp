@@ -178,6 +178,11 @@ namespace amrex
 
     // See if this is an STL description - m_stlIF will be NULL if it isn't
     m_stlIF = dynamic_cast<const STLIF *>(&(*m_implicitFunction));
+    // STLIFs built on a bounding volume hierarchy answer "value" like any other IF
+    if (m_stlIF != NULL && !m_stlIF->useExplorer())
+    {
+      m_stlIF = NULL;
+    }
     m_STLBoxSet = false;
 
     m_verbosity = a_verbosity;
@@ -79,19 +79,17 @@ namespace amrex
 
     if (!locRegion.isEmpty())
     {
-      IntVectSet ivsMulti = a_src.getIVS();
-      ivsMulti &= getIVS();
-      ivsMulti &= locRegion;
       for(int ivof = 0; ivof < m_vofs.size(); ivof++)
       {
         const VolIndex& vof = m_vofs[ivof];
-        const IntVect& iv = vof.gridIndex();
-        if(ivsMulti.contains(iv))
+        if(!locRegion.contains(vof.gridIndex())) continue;
+        int src_ivof = a_src.findVoF(vof);
+        if(src_ivof >= 0)
         {
           for (int icomp = 0; icomp < a_numcomp; ++icomp)
           {
-            a_op.func((*this)(vof, a_destcomp+icomp),
-                      a_src(  vof, a_srccomp+icomp));
+            a_op.func((*this)(ivof,     a_destcomp+icomp),
+                      a_src(  src_ivof, a_srccomp+icomp));
           }
         }
       }
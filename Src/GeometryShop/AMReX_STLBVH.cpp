@@ -0,0 +1,487 @@
+#include "AMReX_STLBVH.H"
+#include "AMReX_BLProfiler.H"
+#include "AMReX.H"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace amrex
+{
+  namespace
+  {
+    inline void toArr(const RealVect& a_rv, Real* a_x)
+    {
+      for (int i = 0; i < 3; i++)
+        a_x[i] = (i < SpaceDim) ? a_rv[i] : 0.0;
+    }
+
+    inline RealVect toRV(const Real* a_x)
+    {
+      RealVect rv;
+      for (int i = 0; i < SpaceDim; i++)
+        rv[i] = a_x[i];
+      return rv;
+    }
+
+    inline Real dot3(const Real* a, const Real* b)
+    {
+      return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+    }
+
+    inline void sub3(const Real* a, const Real* b, Real* c)
+    {
+      c[0] = a[0]-b[0]; c[1] = a[1]-b[1]; c[2] = a[2]-b[2];
+    }
+
+    inline void cross3(const Real* a, const Real* b, Real* c)
+    {
+      c[0] = a[1]*b[2] - a[2]*b[1];
+      c[1] = a[2]*b[0] - a[0]*b[2];
+      c[2] = a[0]*b[1] - a[1]*b[0];
+    }
+
+    inline Real normalize3(Real* a)
+    {
+      Real len = std::sqrt(dot3(a,a));
+      if (len > 0.0)
+      {
+        a[0] /= len; a[1] /= len; a[2] /= len;
+      }
+      return len;
+    }
+  }
+
+  STLBVH::STLBVH(shared_ptr<STLMesh> a_stlmesh,
+                 int                 a_leafSize)
+    : m_msh(a_stlmesh),
+      m_leafSize(std::max(a_leafSize,1))
+  {
+    BL_PROFILE("STLBVH::STLBVH");
+
+    if (SpaceDim != 3)
+    {
+      amrex::Abort("STLBVH: STL geometry requires SpaceDim == 3");
+    }
+
+    const int ntri = m_msh->triangles.corners.size();
+    if (ntri == 0)
+    {
+      amrex::Abort("STLBVH: empty mesh");
+    }
+
+    // per-triangle bounds and centroids
+    Vector<Real> tlo(3*ntri), thi(3*ntri), centroid(3*ntri);
+    for (int itri = 0; itri < ntri; itri++)
+    {
+      for (int idir = 0; idir < 3; idir++)
+      {
+        tlo[3*itri+idir] =  std::numeric_limits<Real>::max();
+        thi[3*itri+idir] = -std::numeric_limits<Real>::max();
+        centroid[3*itri+idir] = 0.0;
+      }
+      for (int icorner = 0; icorner < 3; icorner++)
+      {
+        Real x[3];
+        toArr(m_msh->vertices.vertex[ m_msh->triangles.corners[itri][icorner] ], x);
+        for (int idir = 0; idir < 3; idir++)
+        {
+          tlo[3*itri+idir] = std::min(tlo[3*itri+idir], x[idir]);
+          thi[3*itri+idir] = std::max(thi[3*itri+idir], x[idir]);
+          centroid[3*itri+idir] += x[idir]/3.0;
+        }
+      }
+    }
+
+    m_order.resize(ntri);
+    for (int itri = 0; itri < ntri; itri++)
+      m_order[itri] = itri;
+
+    // a binary tree with leaves of at least m_leafSize/2 triangles
+    m_nodes.reserve(2*(ntri/std::max(m_leafSize/2,1))+1);
+    m_nodes.push_back(Node());
+    buildNode(0, 0, ntri, centroid, tlo, thi);
+
+    // copy the vertex coordinates into tree order so that leaves are contiguous
+    m_tri.resize(9*ntri);
+    for (int islot = 0; islot < ntri; islot++)
+    {
+      const Vector<int>& corners = m_msh->triangles.corners[m_order[islot]];
+      for (int icorner = 0; icorner < 3; icorner++)
+      {
+        toArr(m_msh->vertices.vertex[corners[icorner]], &m_tri[9*islot+3*icorner]);
+      }
+    }
+
+    buildNormals();
+  }
+
+  STLBVH::~STLBVH()
+  {
+  }
+
+  void STLBVH::buildNode(int a_inode, int a_begin, int a_end,
+                         const Vector<Real>& a_centroid,
+                         const Vector<Real>& a_tlo,
+                         const Vector<Real>& a_thi)
+  {
+    Real lo[3], hi[3], clo[3], chi[3];
+    for (int idir = 0; idir < 3; idir++)
+    {
+      lo[idir] = clo[idir] =  std::numeric_limits<Real>::max();
+      hi[idir] = chi[idir] = -std::numeric_limits<Real>::max();
+    }
+    for (int i = a_begin; i < a_end; i++)
+    {
+      int itri = m_order[i];
+      for (int idir = 0; idir < 3; idir++)
+      {
+        lo [idir] = std::min(lo [idir], a_tlo     [3*itri+idir]);
+        hi [idir] = std::max(hi [idir], a_thi     [3*itri+idir]);
+        clo[idir] = std::min(clo[idir], a_centroid[3*itri+idir]);
+        chi[idir] = std::max(chi[idir], a_centroid[3*itri+idir]);
+      }
+    }
+
+    for (int idir = 0; idir < 3; idir++)
+    {
+      m_nodes[a_inode].lo[idir] = lo[idir];
+      m_nodes[a_inode].hi[idir] = hi[idir];
+    }
+
+    // split along the direction of largest centroid spread
+    int  axis   = 0;
+    Real extent = chi[0]-clo[0];
+    for (int idir = 1; idir < 3; idir++)
+    {
+      if (chi[idir]-clo[idir] > extent)
+      {
+        axis   = idir;
+        extent = chi[idir]-clo[idir];
+      }
+    }
+
+    if (a_end - a_begin <= m_leafSize || extent <= 0.0)
+    {
+      m_nodes[a_inode].first = a_begin;
+      m_nodes[a_inode].count = a_end - a_begin;
+      return;
+    }
+
+    int mid = (a_begin + a_end)/2;
+    std::nth_element(m_order.begin()+a_begin, m_order.begin()+mid, m_order.begin()+a_end,
+                     [&](int a, int b) { return a_centroid[3*a+axis] < a_centroid[3*b+axis]; });
+
+    int left = m_nodes.size();
+    m_nodes.push_back(Node());
+    m_nodes.push_back(Node());
+    m_nodes[a_inode].first = left;
+    m_nodes[a_inode].count = 0;
+
+    buildNode(left  , a_begin, mid  , a_centroid, a_tlo, a_thi);
+    buildNode(left+1, mid    , a_end, a_centroid, a_tlo, a_thi);
+  }
+
+  void STLBVH::buildNormals()
+  {
+    BL_PROFILE("STLBVH::buildNormals");
+
+    const int ntri   = m_msh->triangles.corners.size();
+    const int nvert  = m_msh->vertices.vertex.size();
+    const int nedge  = m_msh->edges.edge.size();
+
+    m_faceNormal.resize(ntri);
+    m_vertNormal.assign(nvert, RealVect::Zero);
+    m_edgeNormal.assign(nedge, RealVect::Zero);
+    m_triEdges.assign(3*ntri, -1);
+
+    std::unordered_map<unsigned long long, int> edgeMap;
+    edgeMap.reserve(nedge);
+    for (int iedge = 0; iedge < nedge; iedge++)
+    {
+      unsigned long long n0 = m_msh->edges.edge[iedge][0];
+      unsigned long long n1 = m_msh->edges.edge[iedge][1];
+      edgeMap[(std::min(n0,n1) << 32) | std::max(n0,n1)] = iedge;
+    }
+
+    for (int itri = 0; itri < ntri; itri++)
+    {
+      const Vector<int>& corners = m_msh->triangles.corners[itri];
+      Real x[3][3];
+      for (int icorner = 0; icorner < 3; icorner++)
+        toArr(m_msh->vertices.vertex[corners[icorner]], x[icorner]);
+
+      // geometric normal, oriented to agree with the stored one if it is set
+      Real ab[3], ac[3], n[3], nstored[3];
+      sub3(x[1], x[0], ab);
+      sub3(x[2], x[0], ac);
+      cross3(ab, ac, n);
+      toArr(m_msh->triangles.normal[itri], nstored);
+      if (normalize3(n) == 0.0)
+      {
+        n[0] = nstored[0]; n[1] = nstored[1]; n[2] = nstored[2];
+        normalize3(n);
+      }
+      else if (dot3(n, nstored) < 0.0)
+      {
+        n[0] = -n[0]; n[1] = -n[1]; n[2] = -n[2];
+      }
+      RealVect fn = toRV(n);
+      m_faceNormal[itri] = fn;
+
+      for (int icorner = 0; icorner < 3; icorner++)
+      {
+        // angle-weighted vertex normal
+        Real e1[3], e2[3];
+        sub3(x[(icorner+1)%3], x[icorner], e1);
+        sub3(x[(icorner+2)%3], x[icorner], e2);
+        Real l1 = normalize3(e1);
+        Real l2 = normalize3(e2);
+        if (l1 > 0.0 && l2 > 0.0)
+        {
+          Real c = std::max(Real(-1.0), std::min(Real(1.0), dot3(e1,e2)));
+          m_vertNormal[corners[icorner]] += std::acos(c)*fn;
+        }
+
+        // edge normal is the sum of the two face normals
+        unsigned long long n0 = corners[icorner];
+        unsigned long long n1 = corners[(icorner+1)%3];
+        auto found = edgeMap.find((std::min(n0,n1) << 32) | std::max(n0,n1));
+        if (found != edgeMap.end())
+        {
+          m_triEdges[3*itri+icorner] = found->second;
+          m_edgeNormal[found->second] += fn;
+        }
+      }
+    }
+
+    for (int ivert = 0; ivert < nvert; ivert++)
+    {
+      Real len = m_vertNormal[ivert].vectorLength();
+      if (len > 0.0) m_vertNormal[ivert] /= len;
+    }
+    for (int iedge = 0; iedge < nedge; iedge++)
+    {
+      Real len = m_edgeNormal[iedge].vectorLength();
+      if (len > 0.0) m_edgeNormal[iedge] /= len;
+    }
+  }
+
+  // Ericson, Real-Time Collision Detection, section 5.1.5,
+  // extended to report which feature of the triangle is closest
+  void STLBVH::closestOnTriangle(int         a_slot,
+                                 const Real* a_p,
+                                 Real*       a_c,
+                                 Feature&    a_feature) const
+  {
+    const Real* a = &m_tri[9*a_slot];
+    const Real* b = a+3;
+    const Real* c = a+6;
+
+    Real ab[3], ac[3], ap[3];
+    sub3(b, a, ab);
+    sub3(c, a, ac);
+    sub3(a_p, a, ap);
+    Real d1 = dot3(ab, ap);
+    Real d2 = dot3(ac, ap);
+    if (d1 <= 0.0 && d2 <= 0.0)
+    {
+      a_c[0] = a[0]; a_c[1] = a[1]; a_c[2] = a[2];
+      a_feature = Vert0;
+      return;
+    }
+
+    Real bp[3];
+    sub3(a_p, b, bp);
+    Real d3 = dot3(ab, bp);
+    Real d4 = dot3(ac, bp);
+    if (d3 >= 0.0 && d4 <= d3)
+    {
+      a_c[0] = b[0]; a_c[1] = b[1]; a_c[2] = b[2];
+      a_feature = Vert1;
+      return;
+    }
+
+    Real vc = d1*d4 - d3*d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+    {
+      Real v = d1/(d1-d3);
+      for (int i = 0; i < 3; i++) a_c[i] = a[i] + v*ab[i];
+      a_feature = Edge0;
+      return;
+    }
+
+    Real cp[3];
+    sub3(a_p, c, cp);
+    Real d5 = dot3(ab, cp);
+    Real d6 = dot3(ac, cp);
+    if (d6 >= 0.0 && d5 <= d6)
+    {
+      a_c[0] = c[0]; a_c[1] = c[1]; a_c[2] = c[2];
+      a_feature = Vert2;
+      return;
+    }
+
+    Real vb = d5*d2 - d1*d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+    {
+      Real w = d2/(d2-d6);
+      for (int i = 0; i < 3; i++) a_c[i] = a[i] + w*ac[i];
+      a_feature = Edge2;
+      return;
+    }
+
+    Real va = d3*d6 - d5*d4;
+    if (va <= 0.0 && (d4-d3) >= 0.0 && (d5-d6) >= 0.0)
+    {
+      Real w = (d4-d3)/((d4-d3)+(d5-d6));
+      for (int i = 0; i < 3; i++) a_c[i] = b[i] + w*(c[i]-b[i]);
+      a_feature = Edge1;
+      return;
+    }
+
+    Real denom = 1.0/(va+vb+vc);
+    Real v = vb*denom;
+    Real w = vc*denom;
+    for (int i = 0; i < 3; i++) a_c[i] = a[i] + ab[i]*v + ac[i]*w;
+    a_feature = Face;
+  }
+
+  void STLBVH::query(const Real* a_p,
+                     Real&       a_bestDist2,
+                     int&        a_bestSlot,
+                     Real*       a_bestPoint,
+                     Feature&    a_bestFeature) const
+  {
+    a_bestDist2 = std::numeric_limits<Real>::max();
+    a_bestSlot  = -1;
+
+    // the tree is balanced, so its depth is bounded by log2(ntri)+1
+    int stack[128];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+      const Node& node = m_nodes[stack[--top]];
+
+      Real boxDist2 = 0.0;
+      for (int idir = 0; idir < 3; idir++)
+      {
+        Real d = std::max(node.lo[idir]-a_p[idir], std::max(Real(0.0), a_p[idir]-node.hi[idir]));
+        boxDist2 += d*d;
+      }
+      if (boxDist2 >= a_bestDist2) continue;
+
+      if (node.count > 0)
+      {
+        for (int islot = node.first; islot < node.first+node.count; islot++)
+        {
+          Real c[3], pc[3];
+          Feature f;
+          closestOnTriangle(islot, a_p, c, f);
+          sub3(a_p, c, pc);
+          Real d2 = dot3(pc, pc);
+          if (d2 < a_bestDist2)
+          {
+            a_bestDist2 = d2;
+            a_bestSlot  = islot;
+            a_bestPoint[0] = c[0]; a_bestPoint[1] = c[1]; a_bestPoint[2] = c[2];
+            a_bestFeature = f;
+          }
+        }
+      }
+      else
+      {
+        // visit the nearer child first by pushing it last
+        int left  = node.first;
+        int right = node.first+1;
+        Real cl = 0.0, cr = 0.0;
+        for (int idir = 0; idir < 3; idir++)
+        {
+          Real ml = 0.5*(m_nodes[left ].lo[idir]+m_nodes[left ].hi[idir]) - a_p[idir];
+          Real mr = 0.5*(m_nodes[right].lo[idir]+m_nodes[right].hi[idir]) - a_p[idir];
+          cl += ml*ml;
+          cr += mr*mr;
+        }
+        if (cl < cr)
+        {
+          stack[top++] = right;
+          stack[top++] = left;
+        }
+        else
+        {
+          stack[top++] = left;
+          stack[top++] = right;
+        }
+      }
+    }
+  }
+
+  void STLBVH::closestPoint(const RealVect& a_point,
+                            RealVect&       a_closest,
+                            int&            a_triangle) const
+  {
+    Real p[3], c[3], dist2;
+    int slot;
+    Feature f;
+    toArr(a_point, p);
+    query(p, dist2, slot, c, f);
+    a_closest  = toRV(c);
+    a_triangle = m_order[slot];
+  }
+
+  Real STLBVH::distance(const RealVect& a_point) const
+  {
+    Real p[3], c[3], dist2;
+    int slot;
+    Feature f;
+    toArr(a_point, p);
+    query(p, dist2, slot, c, f);
+    return std::sqrt(dist2);
+  }
+
+  Real STLBVH::signedDistance(const RealVect& a_point) const
+  {
+    Real p[3], c[3], dist2;
+    int slot;
+    Feature f;
+    toArr(a_point, p);
+    query(p, dist2, slot, c, f);
+
+    if (dist2 == 0.0) return 0.0;
+
+    const int itri = m_order[slot];
+    const Vector<int>& corners = m_msh->triangles.corners[itri];
+
+    RealVect pn;
+    int iedge = -1;
+    switch (f)
+    {
+    case Face:
+      pn = m_faceNormal[itri];
+      break;
+    case Edge0: case Edge1: case Edge2:
+      iedge = m_triEdges[3*itri + (f-Edge0)];
+      pn = (iedge >= 0) ? m_edgeNormal[iedge] : m_faceNormal[itri];
+      break;
+    default:
+      pn = m_vertNormal[corners[f-Vert0]];
+      break;
+    }
+
+    Real pc[3], n[3];
+    sub3(p, c, pc);
+    toArr(pn, n);
+
+    Real dist = std::sqrt(dist2);
+    return (dot3(pc, n) > 0.0) ? -dist : dist;
+  }
+
+  void STLBVH::boundingBox(RealVect& a_lo, RealVect& a_hi) const
+  {
+    a_lo = toRV(m_nodes[0].lo);
+    a_hi = toRV(m_nodes[0].hi);
+  }
+}
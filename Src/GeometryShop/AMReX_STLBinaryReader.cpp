@@ -0,0 +1,343 @@
+#include "AMReX_STLBinaryReader.H"
+#include "AMReX_BLProfiler.H"
+#include "AMReX_STLUtil.H"
+
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace amrex
+{
+  using namespace STLUtil;
+
+  namespace
+  {
+    const size_t stl_header_bytes = 80;
+    const size_t stl_record_bytes = 50;
+
+    // vertices are merged on their exact single-precision bit pattern
+    struct VertKey
+    {
+      uint32_t x[3];
+      bool operator==(const VertKey& rhs) const
+        {
+          return x[0]==rhs.x[0] && x[1]==rhs.x[1] && x[2]==rhs.x[2];
+        }
+    };
+
+    struct VertKeyHash
+    {
+      std::size_t operator()(const VertKey& k) const
+        {
+          std::size_t seed = 0;
+          for (int i = 0; i < 3; i++)
+            seed ^= std::hash<uint32_t>()(k.x[i]) + 0x9e3779b9 + (seed<<6) + (seed>>2);
+          return seed;
+        }
+    };
+
+    inline float readFloat(const char* a_p)
+    {
+      float f;
+      std::memcpy(&f, a_p, sizeof(float));
+      return f;
+    }
+
+    inline uint32_t readUInt32(const char* a_p)
+    {
+      uint32_t u;
+      std::memcpy(&u, a_p, sizeof(uint32_t));
+      return u;
+    }
+  }
+
+  struct STLBinaryReader::BuildMaps
+  {
+    std::unordered_map<VertKey, int, VertKeyHash> vertMap;
+    std::unordered_map<uint64_t, int>              edgeMap;
+  };
+
+/// Constructor - read from standard input
+  STLBinaryReader::STLBinaryReader()
+  {
+    m_header = NULL;
+    m_maps = NULL;
+
+    ReadData(cin,0);
+  }
+
+/// Constructor - read from file name
+  STLBinaryReader::STLBinaryReader(const string& a_filename)
+  {
+    BL_PROFILE("STLBinaryReader::STLBinaryReader");
+
+    m_header = NULL;
+    m_maps = NULL;
+
+    int fd = ::open(a_filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      amrex::Abort("STLBinaryReader - unable to open file");
+    }
+
+    struct stat sb;
+    if (::fstat(fd, &sb) != 0 || sb.st_size < (off_t) (stl_header_bytes + sizeof(uint32_t)))
+    {
+      ::close(fd);
+      amrex::Abort("STLBinaryReader - file is too short to be binary STL");
+    }
+    size_t nbytes = sb.st_size;
+
+    void* p = ::mmap(NULL, nbytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED)
+    {
+      // fall back to streaming if the file system does not support mmap
+      ::close(fd);
+      ifstream curFile;
+      curFile.open(a_filename.c_str(),ios::in|ios::binary);
+      if (!curFile.good() || !curFile.is_open())
+      {
+        amrex::Abort("STLBinaryReader - unable to open file");
+      }
+      ReadData(curFile,0);
+      curFile.close();
+      return;
+    }
+    ::madvise(p, nbytes, MADV_SEQUENTIAL);
+
+    ReadBuffer(static_cast<const char*>(p), nbytes);
+
+    ::munmap(p, nbytes);
+    ::close(fd);
+  }
+
+/// Destructor
+  STLBinaryReader::~STLBinaryReader()
+  {
+    delete m_header;
+    delete m_maps;
+  }
+
+/// Return pointer to header string
+  string* STLBinaryReader::GetHeader() const
+  {
+    return m_header;
+  }
+
+/// Return number of elements
+  void STLBinaryReader::GetNtri(int& a_ntri) const
+  {
+    a_ntri = m_ntri;
+  }
+
+/// Return whether number of elements from header matches file
+  void STLBinaryReader::GetNtriMatch(bool& a_ntriMatch) const
+  {
+    a_ntriMatch = m_ntriMatch;
+  }
+
+/// Return pointer to the mesh
+  shared_ptr<STLMesh> STLBinaryReader::GetMesh() const
+  {
+    return m_stlmesh;
+  }
+
+  bool STLBinaryReader::IsBinarySTL(const string& a_filename)
+  {
+    ifstream curFile;
+    curFile.open(a_filename.c_str(),ios::in|ios::binary);
+    if (!curFile.good() || !curFile.is_open())
+    {
+      amrex::Abort("STLBinaryReader::IsBinarySTL - unable to open file");
+    }
+
+    char buf[stl_header_bytes + sizeof(uint32_t)];
+    curFile.read(buf, sizeof(buf));
+    if (curFile.gcount() != (std::streamsize) sizeof(buf))
+      return false;
+
+    curFile.seekg(0, ios::end);
+    size_t nbytes = curFile.tellg();
+
+    // ASCII files start with "solid", but so do some binary headers,
+    // so the size implied by the triangle count is the deciding test
+    uint32_t ntri = readUInt32(buf + stl_header_bytes);
+    return nbytes == stl_header_bytes + sizeof(uint32_t) + stl_record_bytes*size_t(ntri);
+  }
+
+  void STLBinaryReader::BeginMesh(const char* a_header,
+                                  const int   a_ntriDeclared)
+  {
+    shared_ptr<STLMesh> temp(new STLMesh());
+    m_stlmesh = temp;
+    m_stlmesh->tol = 1.0e-10; // maybe do something fancier later, for now just constant
+
+    // header is not null terminated and is usually padded
+    string header(a_header, stl_header_bytes);
+    size_t last = header.find_last_not_of(string(" \0", 2));
+    header = (last == string::npos) ? string() : header.substr(0,last+1);
+    m_header = new string(header.c_str());
+
+    m_ntriDeclared = a_ntriDeclared;
+    m_ntri = 0;
+
+    // reserve using the usual Euler characteristic of closed meshes:
+    // nvert ~ ntri/2 and nedge ~ 3*ntri/2
+    m_stlmesh->triangles.corners.reserve(a_ntriDeclared);
+    m_stlmesh->triangles.normal.reserve(a_ntriDeclared);
+    m_stlmesh->vertices.vertex.reserve(a_ntriDeclared/2+3);
+    m_stlmesh->connect.vertexToTriangle.reserve(a_ntriDeclared/2+3);
+    m_stlmesh->edges.edge.reserve(3*(a_ntriDeclared/2)+3);
+    m_stlmesh->connect.edgeToTriangle.reserve(3*(a_ntriDeclared/2)+3);
+
+    delete m_maps;
+    m_maps = new BuildMaps;
+    m_maps->vertMap.reserve(a_ntriDeclared/2+3);
+    m_maps->edgeMap.reserve(3*(a_ntriDeclared/2)+3);
+  }
+
+  void STLBinaryReader::AddTriangle(const char* a_record)
+  {
+    const int itri = m_ntri;
+
+    RealVect normal;
+    for (int idir = 0; idir < SpaceDim; idir++)
+      normal[idir] = readFloat(a_record + sizeof(float)*idir);
+
+    m_stlmesh->triangles.normal.push_back(normal);
+    m_stlmesh->triangles.corners.push_back(Vector<int>(3,-1));
+    Vector<int>& corners = m_stlmesh->triangles.corners[itri];
+
+    // find or add the vertices
+    for (int ivertl = 0; ivertl < 3; ivertl++)
+    {
+      const char* vp = a_record + sizeof(float)*3*(ivertl+1);
+
+      VertKey key;
+      RealVect vert;
+      for (int j = 0; j < 3; j++)
+      {
+        float f = readFloat(vp + sizeof(float)*j);
+        if (f == 0.0f) f = 0.0f; // do not distinguish -0 from +0
+        std::memcpy(&key.x[j], &f, sizeof(float));
+        if (j < SpaceDim) vert[j] = f;
+      }
+
+      auto found = m_maps->vertMap.find(key);
+      if (found != m_maps->vertMap.end())
+      {
+        corners[ivertl] = found->second;
+      }
+      else
+      {
+        int ivertg = m_stlmesh->vertices.vertex.size();
+        m_stlmesh->vertices.vertex.push_back(vert);
+        m_stlmesh->connect.vertexToTriangle.push_back(Vector<int>());
+        m_maps->vertMap.insert(std::make_pair(key,ivertg));
+        corners[ivertl] = ivertg;
+      }
+    }
+
+    // find or add the edges and update connectivity
+    for (int iedgel = 0; iedgel < 3; iedgel++)
+    {
+      int n0 = corners[ (iedgel)   % 3 ];
+      int n1 = corners[ (iedgel+1) % 3 ];
+      uint64_t key = (uint64_t(std::min(n0,n1)) << 32) | uint64_t(std::max(n0,n1));
+
+      auto found = m_maps->edgeMap.find(key);
+      if (found != m_maps->edgeMap.end())
+      {
+        Vector<int>& e2t = m_stlmesh->connect.edgeToTriangle[found->second];
+        if (e2t[0]==-1)
+          e2t[0] = itri;
+        else if (e2t[1]==-1)
+          e2t[1] = itri;
+        // else: non-manifold edge, ignored as in STLAsciiReader
+      }
+      else
+      {
+        int iedgeg = m_stlmesh->edges.edge.size();
+        Vector<int> tmpedge(2);
+        tmpedge[0] = n0; tmpedge[1] = n1;
+        m_stlmesh->edges.edge.push_back(tmpedge);
+        Vector<int> tmpe2t(2);
+        tmpe2t[0]=itri; tmpe2t[1]=-1;
+        m_stlmesh->connect.edgeToTriangle.push_back(tmpe2t);
+        m_maps->edgeMap.insert(std::make_pair(key,iedgeg));
+      }
+    }
+
+    // add vertex to triangle connectivity
+    m_stlmesh->connect.vertexToTriangle[ corners[0] ].push_back(itri);
+    m_stlmesh->connect.vertexToTriangle[ corners[1] ].push_back(itri);
+    m_stlmesh->connect.vertexToTriangle[ corners[2] ].push_back(itri);
+
+    m_ntri++; // move to next triangle
+  }
+
+  void STLBinaryReader::EndMesh()
+  {
+    delete m_maps;
+    m_maps = NULL;
+
+    m_ntriMatch = (m_ntri == m_ntriDeclared);
+  }
+
+  void STLBinaryReader::ReadBuffer(const char*  a_buf,
+                                   const size_t a_size)
+  {
+    BL_PROFILE("STLBinaryReader::ReadBuffer");
+
+    int ntriDeclared = readUInt32(a_buf + stl_header_bytes);
+    BeginMesh(a_buf, ntriDeclared);
+
+    const char* rec = a_buf + stl_header_bytes + sizeof(uint32_t);
+    const char* end = a_buf + a_size;
+    for (int itri = 0; itri < ntriDeclared && rec + stl_record_bytes <= end; itri++)
+    {
+      AddTriangle(rec);
+      rec += stl_record_bytes;
+    }
+
+    EndMesh();
+  }
+
+  void STLBinaryReader::ReadData(istream&   a_file,
+                                 const int offset)
+  {
+    BL_PROFILE("STLBinaryReader::ReadData");
+
+    char hdr[stl_header_bytes + sizeof(uint32_t)];
+    a_file.read(hdr, sizeof(hdr));
+    if (a_file.gcount() != (std::streamsize) sizeof(hdr))
+    {
+      amrex::Abort("STLBinaryReader - stream is too short to be binary STL");
+    }
+
+    int ntriDeclared = readUInt32(hdr + stl_header_bytes);
+    BeginMesh(hdr, ntriDeclared);
+
+    // stream the triangle records in modest chunks
+    const int chunk = 4096;
+    Vector<char> buf(chunk*stl_record_bytes);
+    int nleft = ntriDeclared;
+    while (nleft > 0 && a_file.good())
+    {
+      int nwant = std::min(nleft, chunk);
+      a_file.read(buf.dataPtr(), nwant*stl_record_bytes);
+      int ngot = a_file.gcount() / stl_record_bytes;
+      for (int i = 0; i < ngot; i++)
+        AddTriangle(buf.dataPtr() + i*stl_record_bytes);
+      nleft -= ngot;
+      if (ngot < nwant) break;
+    }
+
+    EndMesh();
+  }
+}
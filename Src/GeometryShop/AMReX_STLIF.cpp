@@ -1,4 +1,5 @@
 #include "AMReX_STLAsciiReader.H"
+#include "AMReX_STLBinaryReader.H"
 #include "AMReX_STLExplorer.H"
 #include "AMReX_STLMesh.H"
 #include "AMReX_STLBox.H"
@@ -8,12 +9,16 @@
 
 namespace amrex
 {
-  STLIF::STLIF(const string& a_filename)
+  STLIF::STLIF(const string& a_filename,
+               DataType      a_dataType,
+               bool          a_useExplorer)
 
   {
     BL_PROFILE("STLIF::STLIF_file");
 
     m_filename = a_filename;
+    m_dataType = a_dataType;
+    m_useExplorer = a_useExplorer;
 
     makeExplorer();
   }
@@ -23,8 +28,18 @@ namespace amrex
     BL_PROFILE("STLIF::STLIF_copy");
 
     m_filename = a_inputIF.m_filename;
-
-    makeExplorer();
+    m_dataType = a_inputIF.m_dataType;
+    m_useExplorer = a_inputIF.m_useExplorer;
+
+    if (m_useExplorer)
+    {
+      makeExplorer();
+    }
+    else
+    {
+      // the hierarchy is immutable, so copies share it instead of rereading the file
+      m_bvh = a_inputIF.m_bvh;
+    }
   }
 
   STLIF::~STLIF()
@@ -35,7 +50,14 @@ namespace amrex
   {
     Real retval = 0.0;
 
-    amrex::Error("STLIF::value should never be called");
+    if (m_useExplorer)
+    {
+      amrex::Error("STLIF::value should never be called when using the STLExplorer");
+    }
+    else
+    {
+      retval = m_bvh->signedDistance(a_point);
+    }
 
     return retval;
   }
@@ -44,22 +66,51 @@ namespace amrex
   {
     BL_PROFILE("STLIF::newImplicitFunction");
 
-    STLIF* dataFilePtr = new STLIF(m_filename);
+    STLIF* dataFilePtr = new STLIF(*this);
 
     return static_cast<BaseIF*>(dataFilePtr);
   }
 
-  void STLIF::makeExplorer()
+  shared_ptr<STLMesh> STLIF::readMesh() const
   {
-    BL_PROFILE("STLIF::makeExplorer");
+    BL_PROFILE("STLIF::readMesh");
 
     shared_ptr<STLMesh> mesh;
 
-    STLAsciiReader reader(m_filename);
-    mesh = reader.GetMesh();
+    bool binary = (m_dataType == Binary);
+    if (m_dataType == Autodetect)
+    {
+      binary = STLBinaryReader::IsBinarySTL(m_filename);
+    }
+
+    if (binary)
+    {
+      STLBinaryReader reader(m_filename);
+      mesh = reader.GetMesh();
+    }
+    else
+    {
+      STLAsciiReader reader(m_filename);
+      mesh = reader.GetMesh();
+    }
+
+    return mesh;
+  }
+
+  void STLIF::makeExplorer()
+  {
+    BL_PROFILE("STLIF::makeExplorer");
 
+    shared_ptr<STLMesh> mesh = readMesh();
 
-    m_explorer = shared_ptr<STLExplorer>(new STLExplorer(mesh));
+    if (m_useExplorer)
+    {
+      m_explorer = shared_ptr<STLExplorer>(new STLExplorer(mesh));
+    }
+    else
+    {
+      m_bvh = shared_ptr<STLBVH>(new STLBVH(mesh));
+    }
   }
 }
 
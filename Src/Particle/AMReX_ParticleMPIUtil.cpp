@@ -1,10 +1,77 @@
+#include <algorithm>
+#include <fstream>
+
 #include <AMReX_ParticleMPIUtil.H>
 
 #include <AMReX_ParallelDescriptor.H>
 #include <AMReX_BLProfiler.H>
+#include <AMReX_NFiles.H>
+#include <AMReX_Utility.H>
 
 namespace amrex {
 
+    long WriteNFilesGroup (const std::string& filePrefix, int nOutFiles,
+                           const Vector<char>& buf, long chunk_size)
+    {
+        BL_PROFILE("WriteNFilesGroup()");
+
+        const int  MyProc = ParallelDescriptor::MyProc();
+        const int  NProcs = ParallelDescriptor::NProcs();
+        const int  nsets  = NFilesIter::LengthOfSet(NProcs, nOutFiles);
+        const int  fnum   = NFilesIter::FileNumber(nOutFiles, MyProc, false);
+        const int  first  = fnum*nsets;
+        const int  last   = std::min(first + nsets, NProcs) - 1;
+        const int  SeqNum = ParallelDescriptor::SeqNum();
+        const long nbytes = buf.size();
+
+        if (MyProc != first)
+        {
+            //
+            // Tell the writer how much we have, get our offset and send the
+            // data once it asks for them.
+            //
+            long base = 0;
+            ParallelDescriptor::Send(&nbytes, 1, first, SeqNum);
+            ParallelDescriptor::Recv(&base, 1, first, SeqNum);
+            for (long done = 0; done < nbytes; done += chunk_size) {
+                ParallelDescriptor::Send(buf.dataPtr() + done,
+                                         std::min(chunk_size, nbytes - done), first, SeqNum);
+            }
+            return base;
+        }
+
+        const std::string FullFileName = NFilesIter::FileName(fnum, filePrefix);
+        std::ofstream ofs(FullFileName.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        if ( ! ofs.good()) {
+            amrex::FileOpenFailed(FullFileName);
+        }
+
+        ofs.write(buf.dataPtr(), nbytes);
+
+        long offset = nbytes;
+        Vector<char> chunk;
+        for (int proc = first + 1; proc <= last; ++proc)
+        {
+            long n = 0;
+            ParallelDescriptor::Recv(&n, 1, proc, SeqNum);
+            ParallelDescriptor::Send(&offset, 1, proc, SeqNum);
+            chunk.resize(std::min(chunk_size, n));
+            for (long done = 0; done < n; done += chunk_size) {
+                const long m = std::min(chunk_size, n - done);
+                ParallelDescriptor::Recv(chunk.dataPtr(), m, proc, SeqNum);
+                ofs.write(chunk.dataPtr(), m);
+            }
+            offset += n;
+        }
+
+        ofs.close();
+        if ( ! ofs.good()) {
+            amrex::Abort("WriteNFilesGroup(): problem writing " + FullFileName);
+        }
+
+        return 0;
+    }
+
 #ifdef BL_USE_MPI    
     
     long CountSnds(const std::map<int, Vector<char> >& not_ours, Vector<long>& Snds)
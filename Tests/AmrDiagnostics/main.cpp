@@ -0,0 +1,306 @@
+//
+// A test program for the in situ AMR diagnostics.
+//
+// The data on a two-level hierarchy is the index of the level-0 cell each
+// cell lies in, so the exact result of every reduction is known.  The
+// reductions in the inputs file run for several steps with the output
+// written from the background thread, are checked against the exact values,
+// and are run again with amr.diag_async = 0, which must give the same files.
+//
+//     mpiexec -n 4 ./main3d.gnu.MPI.OMP.ex inputs
+//
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <AMReX.H>
+#include <AMReX_AmrDiagnostics.H>
+#include <AMReX_AmrMesh.H>
+#include <AMReX_LevelBld.H>
+#include <AMReX_PROB_AMR_F.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+// No Amr is built here, but the library refers to the application's
+// LevelBld and amrex_probinit.
+amrex::LevelBld* getLevelBld () { return nullptr; }
+void amrex_probinit (const int*, const int*, const int*, const amrex_real*, const amrex_real*) {}
+
+namespace
+{
+    const int  n0     = 32;   // level-0 cells in each direction
+    const int  nsteps = 10;
+    const Real tol    = 1.e-12;
+
+    const char* files[] = { "/zavg.dat", "/xline.dat", "/hist.dat", "/probes.dat",
+                            "/zslice_00000.fab", "/zslice_00005.fab" };
+
+    // The profiles and histograms are appended to, so start from scratch.
+    void
+    removeOutput (const std::string& dir)
+    {
+        if (ParallelDescriptor::IOProcessor())
+            for (const char* f : files)
+                std::remove((dir + f).c_str());
+        ParallelDescriptor::Barrier();
+    }
+
+    // The level-0 index of the cell containing coordinate x.
+    int
+    coarseIndex (Real x)
+    {
+        return static_cast<int>(std::floor(x*n0));
+    }
+
+    // Fill mf on a level refined by ratio with the level-0 index in direction dir.
+    void
+    fillIndex (MultiFab& mf, int dir, int ratio)
+    {
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            FArrayBox& fab = mf[mfi];
+            const Box& bx  = fab.box();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+                fab(iv) = iv[dir] / ratio;
+        }
+    }
+
+    // The rows of the blocks of a profile file, for every step.
+    Vector<Vector<Vector<Real> > >
+    readProfiles (const std::string& file, Vector<int>& steps)
+    {
+        Vector<Vector<Vector<Real> > > blocks;
+        std::ifstream ifs(file.c_str());
+        std::string line;
+        while (std::getline(ifs, line))
+        {
+            std::istringstream is(line);
+            if (line[0] == '#')
+            {
+                std::string word;
+                int step;
+                is >> word >> word >> step;
+                steps.push_back(step);
+                blocks.push_back(Vector<Vector<Real> >());
+                continue;
+            }
+            Vector<Real> row;
+            Real v;
+            while (is >> v)
+                row.push_back(v);
+            blocks.back().push_back(row);
+        }
+        return blocks;
+    }
+
+    // The rows "step time values..." of a histogram or probe file.
+    Vector<Vector<Real> >
+    readRows (const std::string& file)
+    {
+        Vector<Vector<Real> > rows;
+        std::ifstream ifs(file.c_str());
+        std::string line;
+        while (std::getline(ifs, line))
+        {
+            if (line[0] == '#') continue;
+            std::istringstream is(line);
+            Vector<Real> row;
+            Real v;
+            while (is >> v)
+                row.push_back(v);
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+    bool
+    sameFile (const std::string& a, const std::string& b)
+    {
+        std::ifstream fa(a.c_str(), std::ios::binary);
+        std::ifstream fb(b.c_str(), std::ios::binary);
+        if (!fa.good() || !fb.good()) return false;
+        std::string sa((std::istreambuf_iterator<char>(fa)), std::istreambuf_iterator<char>());
+        std::string sb((std::istreambuf_iterator<char>(fb)), std::istreambuf_iterator<char>());
+        return sa == sb;
+    }
+
+    void
+    runDiagnostics (const AmrMesh& mesh,
+                    const std::map<std::string, Vector<const MultiFab*> >& vars)
+    {
+        AmrDiagnostics diags;
+        for (int step = 0; step < nsteps; ++step)
+            diags.compute(mesh, vars, step, 0.1*(step+1), 0.1);
+        AmrDiagnostics::flush();
+    }
+
+    int
+    checkOutput (const std::string& dir, const Geometry& fgeom)
+    {
+        int fails = 0;
+        const int nf = fgeom.Domain().length(0);
+
+        {
+            // z profile of kc and ic.
+            Vector<int> steps;
+            auto blocks = readProfiles(dir + "/zavg.dat", steps);
+            if (static_cast<int>(blocks.size()) != nsteps) ++fails;
+            for (int b = 0; b < static_cast<int>(blocks.size()); ++b)
+            {
+                if (steps[b] != b) ++fails;
+                if (static_cast<int>(blocks[b].size()) != nf) { ++fails; continue; }
+                for (int i = 0; i < nf; ++i)
+                {
+                    const Vector<Real>& row = blocks[b][i];
+                    if (row.size() != 3) { ++fails; continue; }
+                    if (std::abs(row[1] - i/2) > tol) ++fails;
+                    if (std::abs(row[2] - 0.5*(n0-1)) > tol) ++fails;
+                }
+            }
+        }
+
+        {
+            // ic along x.
+            Vector<int> steps;
+            auto blocks = readProfiles(dir + "/xline.dat", steps);
+            if (static_cast<int>(blocks.size()) != nsteps) ++fails;
+            for (int b = 0; b < static_cast<int>(blocks.size()); ++b)
+            {
+                if (static_cast<int>(blocks[b].size()) != nf) { ++fails; continue; }
+                for (int i = 0; i < nf; ++i)
+                    if (std::abs(blocks[b][i][1] - i/2) > tol) ++fails;
+            }
+        }
+
+        {
+            // kc is spread evenly over the bins.
+            auto rows = readRows(dir + "/hist.dat");
+            if (static_cast<int>(rows.size()) != nsteps) ++fails;
+            for (const auto& row : rows)
+                for (int i = 2; i < static_cast<int>(row.size()); ++i)
+                    if (std::abs(row[i] - 1.0/(row.size()-2)) > tol) ++fails;
+        }
+
+        {
+            // ic and kc at each point.
+            Vector<Real> points;
+            ParmParse pp("amr.diag.probes");
+            pp.getarr("points", points, 0, pp.countval("points"));
+            const int npts = points.size() / AMREX_SPACEDIM;
+            auto rows = readRows(dir + "/probes.dat");
+            if (static_cast<int>(rows.size()) != nsteps) ++fails;
+            for (const auto& row : rows)
+            {
+                if (static_cast<int>(row.size()) != 2 + 2*npts) { ++fails; continue; }
+                for (int p = 0; p < npts; ++p)
+                {
+                    if (row[2+2*p  ] != coarseIndex(points[p*AMREX_SPACEDIM])) ++fails;
+                    if (row[2+2*p+1] != coarseIndex(points[p*AMREX_SPACEDIM+AMREX_SPACEDIM-1])) ++fails;
+                }
+            }
+        }
+
+        {
+            // ic and kc on the slice, written every fifth step.
+            Real coord;
+            ParmParse("amr.diag.zslice").get("coord", coord);
+            for (int step = 0; step < nsteps; step += 5)
+            {
+                std::ifstream ifs(amrex::Concatenate(dir + "/zslice_", step, 5) + ".fab");
+                if (!ifs.good()) { ++fails; continue; }
+                FArrayBox fab;
+                fab.readFrom(ifs);
+                const Box& bx = fab.box();
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+                {
+                    if (fab(iv,0) != iv[0]/2) ++fails;
+                    if (fab(iv,1) != coarseIndex(coord)) ++fails;
+                }
+            }
+        }
+
+        return fails;
+    }
+}
+
+int
+main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        RealBox rb;
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            rb.setLo(d, 0.0);
+            rb.setHi(d, 1.0);
+        }
+        AmrMesh mesh(&rb, 1, Vector<int>(AMREX_SPACEDIM, n0), 0, std::vector<int>(1, 2));
+
+        const Box domain = mesh.Geom(0).Domain();
+        BoxArray ba0(domain);
+        ba0.maxSize(8);
+        BoxArray ba1(amrex::refine(Box(IntVect(AMREX_D_DECL(8,8,8)),
+                                       IntVect(AMREX_D_DECL(15,15,15))), 2));
+        ba1.maxSize(8);
+
+        mesh.SetFinestLevel(1);
+        mesh.SetBoxArray(0, ba0);
+        mesh.SetBoxArray(1, ba1);
+        mesh.SetDistributionMap(0, DistributionMapping(ba0));
+        mesh.SetDistributionMap(1, DistributionMapping(ba1));
+
+        Vector<std::unique_ptr<MultiFab> > ic(2), kc(2);
+        std::map<std::string, Vector<const MultiFab*> > vars;
+        for (int lev = 0; lev <= 1; ++lev)
+        {
+            ic[lev].reset(new MultiFab(mesh.boxArray(lev), mesh.DistributionMap(lev), 1, 0));
+            kc[lev].reset(new MultiFab(mesh.boxArray(lev), mesh.DistributionMap(lev), 1, 0));
+            fillIndex(*ic[lev], 0, 1 << lev);
+            fillIndex(*kc[lev], AMREX_SPACEDIM-1, 1 << lev);
+            vars["ic"].push_back(ic[lev].get());
+            vars["kc"].push_back(kc[lev].get());
+        }
+
+        ParmParse pp("amr");
+        std::string dir;
+        pp.get("diag_dir", dir);
+
+        const std::string sync_dir = dir + "_sync";
+        removeOutput(dir);
+        removeOutput(sync_dir);
+
+        runDiagnostics(mesh, vars);
+
+        int fails = 0;
+        if (ParallelDescriptor::IOProcessor())
+            fails += checkOutput(dir, mesh.Geom(1));
+
+        // The same output written before compute returns.
+        pp.add("diag_dir", sync_dir);
+        pp.add("diag_async", 0);
+
+        runDiagnostics(mesh, vars);
+
+        if (ParallelDescriptor::IOProcessor())
+        {
+            for (const char* f : files)
+            {
+                if (!sameFile(dir + f, sync_dir + f)) {
+                    ++fails;
+                    amrex::Print() << dir << f << " and " << sync_dir << f << " differ\n";
+                }
+            }
+        }
+
+        ParallelDescriptor::ReduceIntSum(fails);
+        amrex::Print() << "fails " << fails << "\n";
+        if (fails > 0) {
+            amrex::Abort("AmrDiagnostics: wrong output");
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,103 @@
+//
+// A test program for BoxArray::compact().
+//
+// Compacting a BoxArray changes the storage it shares with its copies in
+// place, so the copies keep their boxes and their RefID.  Two MultiFabs
+// built on copies of one compacted BoxArray must then have the same BDKey
+// and share one FillBoundary cache entry, and FillBoundary must give the
+// same ghost cells as on a BoxArray that was never compacted.
+//
+
+#include <cstring>
+
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+namespace
+{
+    // FabArrayBase keeps its caches to itself.
+    struct FBCacheProbe
+        : public FabArrayBase
+    {
+        static long nbuild () { return m_FBC_stats.nbuild; }
+        static long nuse () { return m_FBC_stats.nuse; }
+        static long count (const BDKey& key) { return m_TheFBCache.count(key); }
+    };
+
+    void
+    fill (MultiFab& mf)
+    {
+        mf.setVal(-1.0);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.validbox();
+            for (int n = 0; n < mf.nComp(); ++n) {
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                    mf[mfi](iv,n) = AMREX_D_TERM(iv[0], + 100.*iv[1], + 10000.*iv[2]) + 1.e6*n;
+                }
+            }
+        }
+    }
+}
+
+int
+main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int fails = 0;
+
+        Box domain(IntVect::TheZeroVector(), IntVect(AMREX_D_DECL(63,63,63)));
+        BoxArray ba(domain);
+        ba.maxSize(IntVect(AMREX_D_DECL(8,16,8)));
+        DistributionMapping dm(ba);
+
+        // Not compacted, with storage of its own.
+        const BoxArray expanded{BoxList(ba)};
+
+        BoxArray copy = ba;
+        const BoxArray::RefID id = ba.getRefID();
+        if (!ba.compact()) ++fails;
+        if (ba.getRefID() != id || copy.getRefID() != id) ++fails;
+        if (copy.size() != expanded.size()) ++fails;
+        for (int i = 0; i < expanded.size(); ++i) {
+            if (copy[i] != expanded[i]) ++fails;
+        }
+
+        MultiFab mf1(ba,   dm, 1, 2);
+        MultiFab mf2(copy, dm, 3, 2);
+        MultiFab mf3(expanded, dm, 3, 2);
+        if (mf1.getBDKey() != mf2.getBDKey()) ++fails;
+
+        fill(mf1);
+        fill(mf2);
+        fill(mf3);
+
+        const long nbuild = FBCacheProbe::nbuild();
+        mf1.FillBoundary();
+        if (FBCacheProbe::nbuild() != nbuild+1) ++fails;
+        const long nuse = FBCacheProbe::nuse();
+        mf2.FillBoundary();
+        if (FBCacheProbe::nbuild() != nbuild+1) ++fails;
+        if (FBCacheProbe::nuse() <= nuse) ++fails;
+        if (FBCacheProbe::count(mf2.getBDKey()) != 1) ++fails;
+
+        mf3.FillBoundary();
+        for (MFIter mfi(mf2); mfi.isValid(); ++mfi)
+        {
+            const FArrayBox& a = mf2[mfi];
+            const FArrayBox& b = mf3[mfi];
+            if (std::memcmp(a.dataPtr(), b.dataPtr(), a.nBytes()) != 0) ++fails;
+        }
+
+        ParallelDescriptor::ReduceIntSum(fails);
+        amrex::Print() << "fails " << fails << "\n";
+        if (fails > 0) {
+            amrex::Abort("tCompactBA: compacting a BoxArray changed its copies or their metadata");
+        }
+    }
+    amrex::Finalize();
+}
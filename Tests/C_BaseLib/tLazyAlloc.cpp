@@ -0,0 +1,115 @@
+//
+// A test program for MFInfo::SetLazy.
+//
+// The fabs of a lazy MultiFab must get their memory on their first access
+// in an MFIter loop and not before.  The tiles are small, so that the tiles
+// of one fab are visited by several threads at once: each fab must still be
+// allocated once, and no thread may lose what it wrote.  Run it with
+// OpenMP and several threads.
+//
+
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+namespace
+{
+    Real
+    fval (const IntVect& iv, int n)
+    {
+        return AMREX_D_TERM(iv[0], + 100.*iv[1], + 10000.*iv[2]) + 1.e6*n;
+    }
+
+    // Bytes of the local fabs whose global index has the given parity,
+    // or of all local fabs if parity < 0.
+    long
+    fabBytes (const MultiFab& mf, int parity)
+    {
+        long nbytes = 0;
+        for (int i = 0; i < mf.IndexArray().size(); ++i) {
+            const int K = mf.IndexArray()[i];
+            if (parity < 0 || K % 2 == parity) {
+                nbytes += mf.fabbox(K).numPts() * mf.nComp() * sizeof(Real);
+            }
+        }
+        return nbytes;
+    }
+
+    // Write the tiles of the fabs whose global index has the given parity.
+    void
+    fill (MultiFab& mf, int parity)
+    {
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        for (MFIter mfi(mf, IntVect(AMREX_D_DECL(4,4,4))); mfi.isValid(); ++mfi)
+        {
+            if (mfi.index() % 2 != parity) continue;
+            const Box& bx = mfi.growntilebox();
+            FArrayBox& fab = mf[mfi];
+            for (int n = 0; n < mf.nComp(); ++n) {
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                    fab(iv,n) = fval(iv,n);
+                }
+            }
+        }
+    }
+}
+
+int
+main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        Box domain(IntVect::TheZeroVector(), IntVect(AMREX_D_DECL(63,63,63)));
+        BoxArray ba(domain);
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        int fails = 0;
+
+        const long b0 = TotalBytesAllocatedInFabs();
+
+        MultiFab mf(ba, dm, 2, 1, MFInfo().SetLazy(true));
+
+        // Nothing is allocated yet.
+        const long b1 = TotalBytesAllocatedInFabs();
+        if (b1 != b0) ++fails;
+
+        // Only the fabs that are touched.
+        fill(mf, 0);
+        const long b2 = TotalBytesAllocatedInFabs();
+        if (b2 - b1 != fabBytes(mf, 0)) ++fails;
+
+        // The others, and none of the first ones again.
+        fill(mf, 1);
+        const long b3 = TotalBytesAllocatedInFabs();
+        if (b3 - b1 != fabBytes(mf, -1)) ++fails;
+
+        amrex::Print() << "bytes allocated: " << b1 - b0 << " after define, "
+                       << b2 - b1 << " after the first loop, "
+                       << b3 - b1 << " after the second loop\n";
+
+        long nbad = 0;
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const FArrayBox& fab = mf[mfi];
+            const Box& bx = fab.box();
+            for (int n = 0; n < mf.nComp(); ++n) {
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                    if (fab(iv,n) != fval(iv,n)) ++nbad;
+                }
+            }
+        }
+        if (nbad > 0) ++fails;
+
+        ParallelDescriptor::ReduceIntSum(fails);
+        amrex::Print() << "fails " << fails << "\n";
+        if (fails > 0) {
+            amrex::Abort("tLazyAlloc: lazy fabs allocated at the wrong time or lost data");
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,148 @@
+//
+// A test program for the neighborhood-collective backend of ParallelCopy
+// (fabarray.neighbor_collective_threshold).
+//
+// Every copy is done twice on the same data, once with point-to-point
+// messages and once with MPI_Ineighbor_alltoallv, and the results must
+// be identical.  The BoxArrays are rebuilt for every pattern so that the
+// neighborhood communicators of freed BoxArrays are retired and new ones
+// are built.  Run it with several processes.
+//
+
+#include <cstring>
+
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+namespace
+{
+    const int N = 48;
+
+    Real
+    fval (IntVect iv, int n)
+    {
+        for (int d = 0; d < BL_SPACEDIM; ++d) iv[d] = (iv[d] + N) % N;
+        return D_TERM(iv[0], + 100.*iv[1], + 10000.*iv[2]) + 1.e6*n;
+    }
+
+    void
+    init (MultiFab& mf)
+    {
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.validbox();
+            for (int n = 0; n < mf.nComp(); ++n) {
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                    mf[mfi](iv,n) = fval(iv,n);
+                }
+            }
+        }
+    }
+
+    // Number of values that differ in the bits.
+    int
+    compare (const MultiFab& a, const MultiFab& b)
+    {
+        int nf = 0;
+        for (MFIter mfi(a); mfi.isValid(); ++mfi)
+        {
+            const FArrayBox& fa = a[mfi];
+            const FArrayBox& fb = b[mfi];
+            if (std::memcmp(fa.dataPtr(), fb.dataPtr(), fa.nBytes()) != 0) ++nf;
+        }
+        return nf;
+    }
+
+    // Number of values that are not scale*fval+off.
+    int
+    check (const MultiFab& mf, Real scale, Real off)
+    {
+        int nf = 0;
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (int n = 0; n < mf.nComp(); ++n) {
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                    if (mf[mfi](iv,n) != scale*fval(iv,n)+off) ++nf;
+                }
+            }
+        }
+        return nf;
+    }
+
+    DistributionMapping
+    makeDM (const BoxArray& ba, int kind)
+    {
+        const int nprocs = ParallelDescriptor::NProcs();
+        Vector<int> pmap(ba.size());
+        for (int i = 0; i < ba.size(); ++i) {
+            pmap[i] = (kind == 0) ? 0 : i % nprocs;
+        }
+        return (kind == 2) ? DistributionMapping(ba) : DistributionMapping(pmap);
+    }
+}
+
+int
+main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        const int threshold = FabArrayBase::neighbor_collective_threshold;
+        const int maxcomp   = FabArrayBase::MaxComp;
+
+        Box domain(IntVect::TheZeroVector(), IntVect(D_DECL(N-1,N-1,N-1)));
+        Periodicity period(IntVect(D_DECL(N,N,N)));
+        const int ncomp = 3;
+
+        int fails = 0;
+        int ncopies = 0;
+
+        for (int srcsize : {8, 16}) {
+        for (int dstsize : {12, 24}) {
+        for (int srcdm = 0; srcdm < 3; ++srcdm) {
+        for (int dstdm = 0; dstdm < 3; ++dstdm) {
+        for (int ngrow : {0, 1}) {
+        for (int op : {0, 1}) {
+        for (int mc : {1, maxcomp}) {
+            BoxArray srcba(domain);
+            srcba.maxSize(srcsize);
+            BoxArray dstba(domain);
+            dstba.maxSize(dstsize);
+            const DistributionMapping sdm = makeDM(srcba, srcdm);
+            const DistributionMapping ddm = makeDM(dstba, dstdm);
+
+            MultiFab src(srcba, sdm, ncomp, 0);
+            init(src);
+
+            MultiFab dst[2];
+            for (int backend = 0; backend < 2; ++backend)
+            {
+                FabArrayBase::neighbor_collective_threshold = (backend == 0) ? -1 : 0;
+                FabArrayBase::MaxComp = mc;
+
+                dst[backend].define(dstba, ddm, ncomp, ngrow);
+                dst[backend].setVal(1.0);
+                dst[backend].ParallelCopy(src, 0, 0, ncomp, IntVect::TheZeroVector(),
+                                          IntVect(ngrow), period,
+                                          op ? FabArrayBase::ADD : FabArrayBase::COPY);
+            }
+
+            fails += compare(dst[0], dst[1]);
+            fails += check(dst[1], 1.0, op ? 1.0 : 0.0);
+            ++ncopies;
+        }}}}}}}
+
+        FabArrayBase::neighbor_collective_threshold = threshold;
+        FabArrayBase::MaxComp = maxcomp;
+
+        ParallelDescriptor::ReduceIntSum(fails);
+        amrex::Print() << ncopies << " copies, fails " << fails << "\n";
+        if (fails > 0) {
+            amrex::Abort("tPCNeighbor: the ParallelCopy backends differ");
+        }
+    }
+    amrex::Finalize();
+}
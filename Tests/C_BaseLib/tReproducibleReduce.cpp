@@ -0,0 +1,166 @@
+//
+// A test program for multifab.reproducible_reductions.
+//
+// The sums, dots and norms of the same data must have the same bits for
+// every distribution of the boxes over the processes, every tile size and
+// every number of threads, both from the blocking functions and from a
+// ReduceBatch.  The reference values are printed in hex so that runs with
+// different numbers of processes can be compared too, e.g.,
+//
+//     mpiexec -n 1 ./tReproducibleReduce... | grep ref > 1.out
+//     mpiexec -n 3 ./tReproducibleReduce... | grep ref > 3.out
+//     diff 1.out 3.out
+//
+
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParallelReduce.H>
+#include <AMReX_Print.H>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace amrex;
+
+namespace
+{
+    const int nvals = 8;
+
+    // Values spanning many orders of magnitude, so that the sum depends on
+    // the order of the additions.  They depend on the cell only.
+    void
+    fill (MultiFab& mf, Real shift)
+    {
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            FArrayBox& fab = mf[mfi];
+            const Box& bx = fab.box();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+            {
+                const Real x = iv[0] + 37*iv[1] + 1031*iv[2] + shift;
+                fab(iv,0) = std::sin(x) * std::pow(10.0, std::fmod(std::abs(x), 17.0) - 8.0);
+            }
+        }
+    }
+
+    void
+    compute (const BoxArray& ba, const DistributionMapping& dm, Real* r)
+    {
+        MultiFab x(ba, dm, 1, 1);
+        MultiFab y(ba, dm, 1, 1);
+        fill(x, 0.0);
+        fill(y, 0.5);
+
+        r[0] = x.sum(0);
+        r[1] = MultiFab::Dot(x, 0, y, 0, 1, 1);
+        r[2] = x.norm1(0, 1);
+        r[3] = x.norm2(0);
+
+        ReduceBatch batch;
+        auto bsum  = x.sum(batch, 0);
+        auto bdot  = MultiFab::Dot(batch, x, 0, y, 0, 1, 1);
+        auto bnrm1 = x.norm1(batch, 0, 1);
+        auto bnrm2 = x.norm2(batch, 0);
+        batch.post();
+        r[4] = bsum.get();
+        r[5] = bdot.get();
+        r[6] = bnrm1.get();
+        r[7] = bnrm2.get();
+    }
+
+    std::string
+    hex (Real v)
+    {
+        unsigned long long u = 0;
+        std::memcpy(&u, &v, sizeof(Real));
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%016llx", u);
+        return std::string(buf);
+    }
+}
+
+int
+main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        MultiFab::reproducible_reductions = true;
+
+        const int nprocs = ParallelDescriptor::NProcs();
+
+        Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(47,47,47)));
+        BoxArray ba(domain);
+        ba.maxSize(12);
+        const int nboxes = ba.size();
+
+        Vector<DistributionMapping> dms;
+        dms.push_back(DistributionMapping(Vector<int>(nboxes, 0)));
+        {
+            Vector<int> pmap(nboxes);
+            for (int i = 0; i < nboxes; ++i) pmap[i] = i % nprocs;
+            dms.push_back(DistributionMapping(pmap));
+            for (int i = 0; i < nboxes; ++i) pmap[i] = (nboxes-1-i) % nprocs;
+            dms.push_back(DistributionMapping(pmap));
+        }
+        dms.push_back(DistributionMapping(ba));
+
+        Real ref[nvals];
+        compute(ba, dms[0], ref);
+
+        const char* names[nvals] = { "sum", "dot", "norm1", "norm2",
+                                     "batch sum", "batch dot", "batch norm1", "batch norm2" };
+        for (int i = 0; i < nvals; ++i) {
+            amrex::Print() << "ref " << names[i] << " " << hex(ref[i]) << "\n";
+        }
+
+        // The batch results must match the blocking ones.
+        int fails = 0;
+        for (int i = 0; i < nvals/2; ++i) {
+            if (std::memcmp(&ref[i], &ref[i+nvals/2], sizeof(Real)) != 0) ++fails;
+        }
+
+        const IntVect tile_size = FabArrayBase::mfiter_tile_size;
+        const Vector<IntVect> tile_sizes { tile_size, IntVect(D_DECL(4,4,4)),
+                                           IntVect(D_DECL(1024,2,2)) };
+#ifdef _OPENMP
+        const int max_threads = omp_get_max_threads();
+        const Vector<int> threads { 1, max_threads, max_threads+2 };
+#else
+        const Vector<int> threads { 1 };
+#endif
+
+        for (const auto& dm : dms) {
+            for (const auto& ts : tile_sizes) {
+                for (int nt : threads) {
+                    FabArrayBase::mfiter_tile_size = ts;
+#ifdef _OPENMP
+                    omp_set_num_threads(nt);
+#endif
+                    Real r[nvals];
+                    compute(ba, dm, r);
+                    for (int i = 0; i < nvals; ++i) {
+                        if (std::memcmp(&r[i], &ref[i], sizeof(Real)) != 0) {
+                            ++fails;
+                            amrex::Print() << "mismatch in " << names[i] << ": "
+                                           << hex(r[i]) << " != " << hex(ref[i]) << "\n";
+                        }
+                    }
+                }
+            }
+        }
+
+        FabArrayBase::mfiter_tile_size = tile_size;
+
+        ParallelDescriptor::ReduceIntMax(fails);
+        amrex::Print() << "fails " << fails << "\n";
+        if (fails > 0) {
+            amrex::Abort("tReproducibleReduce: results differ");
+        }
+    }
+    amrex::Finalize();
+}
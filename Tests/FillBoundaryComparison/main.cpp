@@ -12,6 +12,208 @@
 
 using namespace amrex;
 
+namespace
+{
+    // A value that identifies the cell and the component.
+    Real
+    fval (const IntVect& iv, int n)
+    {
+        return AMREX_D_TERM(iv[0], + 1.e4*iv[1], + 1.e8*iv[2]) + 1.e12*n;
+    }
+
+    void
+    fillAll (MultiFab& mf)
+    {
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            FArrayBox& fab = mf[mfi];
+            const Box& bx = fab.box();
+            for (int n = 0; n < mf.nComp(); ++n) {
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                    fab(iv,n) = fval(iv,n);
+                }
+            }
+        }
+    }
+}
+
+//
+// Fill the ghost cells of a MultiFab with FillBoundary and check them
+// against what the point-by-point copies would give: every ghost cell
+// inside another valid box gets that box's value, the others are left
+// alone.  Returns the number of wrong cells.
+//
+static long
+CheckFillBoundary (const BoxArray& ba, const DistributionMapping& dm,
+                   int ncomp, int ng)
+{
+    MultiFab mf(ba, dm, ncomp, ng);
+    mf.setVal(-1.0);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        const Box& vbx = mfi.validbox();
+        for (int n = 0; n < ncomp; ++n) {
+            for (IntVect iv = vbx.smallEnd(); iv <= vbx.bigEnd(); vbx.next(iv)) {
+                mf[mfi](iv,n) = fval(iv,n);
+            }
+        }
+    }
+
+    mf.FillBoundary();
+
+    long nbad = 0;
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        const FArrayBox& fab = mf[mfi];
+        const Box& gbx = fab.box();
+
+        BaseFab<int> filled(gbx, 1);
+        filled.setVal(0);
+        for (const auto& is : ba.intersections(gbx)) {
+            filled.setVal(1, is.second, 0, 1);
+        }
+
+        for (int n = 0; n < ncomp; ++n) {
+            for (IntVect iv = gbx.smallEnd(); iv <= gbx.bigEnd(); gbx.next(iv)) {
+                const Real expected = filled(iv) ? fval(iv,n) : -1.0;
+                if (fab(iv,n) != expected) ++nbad;
+            }
+        }
+    }
+    ParallelDescriptor::ReduceLongSum(nbad);
+    return nbad;
+}
+
+//
+// Time packing the regions FillBoundary sends (the slabs of width ng along
+// each face of the valid boxes) and the whole valid boxes, as ParallelCopy
+// between MultiFabs without ghost cells does, into communication buffers
+// and unpacking them back.  The buffers must be laid out as the Fortran
+// kernels lay them out (components outermost, then k, j, i), and unpacking
+// must restore the data.  Returns the number of wrong values.
+//
+static long
+PackBenchmark (const BoxArray& ba, const DistributionMapping& dm,
+               int ncomp, int ng, int nrounds)
+{
+    MultiFab mfg(ba, dm, ncomp, ng);
+    MultiFab mf0(ba, dm, ncomp, 0);
+    fillAll(mfg);
+    fillAll(mf0);
+
+    long nbad = 0;
+
+    for (int kind = 0; kind <= AMREX_SPACEDIM; ++kind)
+    {
+        MultiFab& mf = (kind == AMREX_SPACEDIM) ? mf0 : mfg;
+
+        // kind < AMREX_SPACEDIM: the two slabs normal to direction kind
+        // kind == AMREX_SPACEDIM: the whole valid box
+        Vector<std::pair<int,Box> > regions;
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& vbx = mfi.validbox();
+            if (kind == AMREX_SPACEDIM) {
+                regions.push_back(std::make_pair(mfi.index(), vbx));
+            } else {
+                Box lo = vbx, hi = vbx;
+                lo.setBig  (kind, vbx.smallEnd(kind)+ng-1);
+                hi.setSmall(kind, vbx.bigEnd(kind)-ng+1);
+                regions.push_back(std::make_pair(mfi.index(), lo));
+                regions.push_back(std::make_pair(mfi.index(), hi));
+            }
+        }
+
+        const int N = regions.size();
+        Vector<char*> ptrs(N);
+        std::size_t nbytes = 0;
+        for (int i = 0; i < N; ++i) {
+            nbytes += mf[regions[i].first].nBytes(regions[i].second, 0, ncomp);
+        }
+        Vector<char> buffer(nbytes);
+        char* p = buffer.data();
+        for (int i = 0; i < N; ++i) {
+            ptrs[i] = p;
+            p += mf[regions[i].first].nBytes(regions[i].second, 0, ncomp);
+        }
+
+        Real tpack = 0.0, tunpack = 0.0;
+        for (int iround = 0; iround < nrounds; ++iround)
+        {
+            Real t0 = ParallelDescriptor::second();
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (int i = 0; i < N; ++i) {
+                mf[regions[i].first].copyToMem(regions[i].second, 0, ncomp, ptrs[i]);
+            }
+            Real t1 = ParallelDescriptor::second();
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (int i = 0; i < N; ++i) {
+                mf[regions[i].first].copyFromMem(regions[i].second, 0, ncomp, ptrs[i]);
+            }
+            Real t2 = ParallelDescriptor::second();
+            tpack   += t1-t0;
+            tunpack += t2-t1;
+        }
+
+        // The buffer holds the values of the last pack, in Fortran order.
+        for (int i = 0; i < N; ++i) {
+            const Box& bx = regions[i].second;
+            const Real* q = reinterpret_cast<const Real*>(ptrs[i]);
+            for (int n = 0; n < ncomp; ++n) {
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                    if (*q++ != fval(iv,n)) ++nbad;
+                }
+            }
+        }
+
+        // Unpacking into cleared fabs restores them.
+        mf.setVal(0.0);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int i = 0; i < N; ++i) {
+            mf[regions[i].first].copyFromMem(regions[i].second, 0, ncomp, ptrs[i]);
+        }
+        for (int i = 0; i < N; ++i) {
+            const FArrayBox& fab = mf[regions[i].first];
+            const Box& bx = regions[i].second;
+            for (int n = 0; n < ncomp; ++n) {
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                    if (fab(iv,n) != fval(iv,n)) ++nbad;
+                }
+            }
+        }
+        fillAll(mf);
+
+        ParallelDescriptor::ReduceRealMax(tpack,   ParallelDescriptor::IOProcessorNumber());
+        ParallelDescriptor::ReduceRealMax(tunpack, ParallelDescriptor::IOProcessorNumber());
+
+        if (ParallelDescriptor::IOProcessor()) {
+            const Real gb = Real(nbytes)*nrounds/1.e9;
+            if (kind == AMREX_SPACEDIM) {
+                std::cout << "Pack whole boxes:  ";
+            } else {
+                std::cout << "Pack slabs normal to direction " << kind << ": ";
+            }
+            std::cout << "pack " << gb/tpack << " GB/s, unpack " << gb/tunpack
+                      << " GB/s" << std::endl;
+        }
+    }
+
+    ParallelDescriptor::ReduceLongSum(nbad);
+    return nbad;
+}
+
 int
 main (int argc, char* argv[])
 {
@@ -169,6 +371,28 @@ main (int argc, char* argv[])
 	std::cout << "ignore this line " << err << std::endl;
     }
 
+    int pack_nrounds = 10;
+    int pack_ncomp = 4;
+    int pack_ngrow = 2;
+    {
+	ParmParse pp;
+	pp.query("pack_nrounds", pack_nrounds);
+	pp.query("pack_ncomp", pack_ncomp);
+	pp.query("pack_ngrow", pack_ngrow);
+    }
+
+    if (pack_nrounds > 0) {
+        const long nbad_pack = PackBenchmark(ba, dm, pack_ncomp, pack_ngrow, pack_nrounds);
+        const long nbad_fb   = CheckFillBoundary(ba, dm, pack_ncomp, pack_ngrow);
+        if (ParallelDescriptor::IOProcessor()) {
+            std::cout << "Wrong packed values: " << nbad_pack
+                      << ", wrong ghost cells: " << nbad_fb << std::endl;
+        }
+        if (nbad_pack > 0 || nbad_fb > 0) {
+            amrex::Abort("FillBoundaryComparison: pack/unpack gives wrong values");
+        }
+    }
+
     //
     // When MPI3 shared memory is used, the dtor of MultiFab calls MPI
     // functions.  Because the scope of mfs is beyond the call to
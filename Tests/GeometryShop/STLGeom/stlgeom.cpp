@@ -21,11 +21,13 @@
 #include "AMReX_VoFIterator.H"
 #include "AMReX_PlotFileUtil.H"
 #include "AMReX_EBLevelGrid.H"
+#include "AMReX_iMultiFab.H"
 
 using namespace amrex;
 
 int makeGeometry(Box& a_domain,
-                 Real& a_dx)
+                 Real& a_dx,
+                 bool a_useBVH)
 {
   int eekflag =  0;
   int maxbox;
@@ -65,7 +67,11 @@ int makeGeometry(Box& a_domain,
   string stlfile;
   pp.get("STL_file", stlfile);
 
-  STLIF implicit(stlfile);
+  // stl_type: 0 = ascii, 1 = binary, 2 = detect from the file
+  int stl_type = 0;
+  pp.query("STL_type", stl_type);
+
+  STLIF implicit(stlfile, static_cast<STLIF::DataType>(stl_type), !a_useBVH);
 
 
   GeometryShop workshop(implicit);
@@ -102,15 +108,117 @@ void  fillEBMF(MultiFab& a_mf, const EBLevelGrid& a_eblg, const Real& a_dx)
   }
 }
 /****/
+//0 = covered, 1 = regular, 2 = irregular
+void  fillCellType(iMultiFab& a_mf, const EBLevelGrid& a_eblg)
+{
+  for(MFIter mfi(a_eblg.getDBL(), a_eblg.getDM()); mfi.isValid(); ++mfi)
+  {
+    const Box& valid = a_eblg.getDBL()[mfi];
+    const EBISBox& ebisBox = a_eblg.getEBISL()[mfi];
+    for(BoxIterator bit(valid); bit.ok(); ++bit)
+    {
+      const IntVect& iv = bit();
+      int celltype = 2;
+      if(ebisBox.isCovered(iv))
+      {
+        celltype = 0;
+      }
+      else if(ebisBox.isRegular(iv))
+      {
+        celltype = 1;
+      }
+      a_mf[mfi](iv, 0) = celltype;
+    }
+  }
+}
+/****/
+//the signed distances of the BVH have to put every cell on the same
+//side of the surface as the STLExplorer does
+int checkBVH()
+{
+  Box domain;
+  Real dx;
+  amrex::Print() << "making EBIS with the STLExplorer" << endl;
+  int eekflag = makeGeometry(domain, dx, false);
+  if(eekflag != 0) return eekflag;
+
+  BoxArray ba(domain);
+  ParmParse pp;
+  int maxbox;
+  pp.get("maxboxsize", maxbox);
+  ba.maxSize(maxbox);
+  DistributionMapping dm(ba);
+
+  iMultiFab explorer(ba, dm, 1, 0);
+  {
+    EBLevelGrid eblg(ba, dm, domain, 0);
+    fillCellType(explorer, eblg);
+  }
 
+  amrex::Print() << "making EBIS with the BVH" << endl;
+  eekflag = makeGeometry(domain, dx, true);
+  if(eekflag != 0) return eekflag;
+
+  iMultiFab bvh(ba, dm, 1, 0);
+  {
+    EBLevelGrid eblg(ba, dm, domain, 0);
+    fillCellType(bvh, eblg);
+  }
+
+  long ncells[3] = {0, 0, 0};
+  long ndiff = 0;
+  for(MFIter mfi(bvh); mfi.isValid(); ++mfi)
+  {
+    const Box& valid = mfi.validbox();
+    for(BoxIterator bit(valid); bit.ok(); ++bit)
+    {
+      const IntVect& iv = bit();
+      ncells[explorer[mfi](iv, 0)]++;
+      if(explorer[mfi](iv, 0) != bvh[mfi](iv, 0))
+      {
+        ndiff++;
+      }
+    }
+  }
+  ParallelDescriptor::ReduceLongSum(ncells, 3);
+  ParallelDescriptor::ReduceLongSum(ndiff);
+
+  amrex::Print() << "covered = "     << ncells[0]
+                 << ", regular = "   << ncells[1]
+                 << ", irregular = " << ncells[2]
+                 << ", cells that differ = " << ndiff << endl;
+  if(ndiff != 0)
+  {
+    return -2;
+  }
+  //a mesh that was not read should not pass
+  if(ncells[0] == 0 || ncells[2] == 0)
+  {
+    return -3;
+  }
+  return 0;
+}
+/****/
 int stlgeom()
 {
   
   Box domain;
   Real dx;
+  ParmParse pp;
+  // use_bvh: query signed distances instead of walking cells with the STLExplorer
+  bool use_bvh = false;
+  pp.query("STL_use_bvh", use_bvh);
+  // check_bvh: build the EBIS both ways and compare instead of writing a plotfile
+  bool check_bvh = false;
+  pp.query("STL_check_bvh", check_bvh);
+  if(check_bvh)
+  {
+    return checkBVH();
+  }
+
   //make the initial geometry
   amrex::Print() << "making EBIS" << endl;
-  makeGeometry(domain, dx);
+  makeGeometry(domain, dx, use_bvh);
 
   BoxArray ba(domain);
   DistributionMapping dm(ba);
@@ -152,7 +260,8 @@ main(int argc,char **argv)
       cout << "stl test passed" << endl;
     }
 
-  return 0;
+  amrex::Finalize();
+  return eekflag;
 }
 
 
@@ -14,6 +14,7 @@
 #include "AMReX_EBArith.H"
 #include "AMReX_AllRegularService.H"
 #include "AMReX_PlaneIF.H"
+#include "AMReX_STLIF.H"
 #include "AMReX_SPMD.H"
 #include "AMReX_Print.H"
 #include "AMReX_EBFluxFactory.H"
@@ -26,6 +27,8 @@
 #include "AMReX_EBDataVarMacros.H"
 #include "AMReX_FabArrayIO.H"
 #include "AMReX_parstream.H"
+#include "AMReX_GraphNode.H"
+#include <cstring>
 
 
 namespace amrex
@@ -162,7 +165,18 @@ donotcallpls()
 
     int whichgeom;
     pp.get("which_geom",whichgeom);
-    if (whichgeom == 0)
+    if (igeom == 2)
+    {
+      //an stl file walked with the explorer, which has no value function
+      string stlfile;
+      pp.get("stl_file", stlfile);
+      amrex::Print() << "stl geometry from " << stlfile << "\n";
+      STLIF implicit(stlfile, STLIF::Autodetect);
+      GeometryShop workshop(implicit);
+      EBIndexSpace* ebisPtr = AMReX_EBIS::instance();
+      ebisPtr->define(a_domain, origin, a_dx, workshop, maxbox);
+    }
+    else if (whichgeom == 0)
     {
       //allregular
       amrex::Print() << "all regular geometry" << "\n";
@@ -285,6 +299,53 @@ donotcallpls()
     return 0;
   }
   /****/
+  //the graph is written cell by cell in the layout of the former GraphNode.
+  //read every cell with GraphNode and check that it writes the same bytes.
+  int checkGraphBytes(const FabArray<EBGraph > & a_ebg,
+                      const EBLevelGrid        & a_eblg)
+  {
+    for(MFIter mfi(a_eblg.getDBL(), a_eblg.getDM()); mfi.isValid(); ++mfi)
+    {
+      const EBGraph& ebg = a_ebg[mfi];
+      const Box& grid = a_eblg.getDBL()[mfi];
+      vector<unsigned char> buf(ebg.nBytes(grid, 0, 1));
+      size_t nbytes = ebg.copyToMem(grid, 0, 1, buf.data());
+      if(nbytes != buf.size())
+      {
+        amrex::Print() << "checkgraphbytes: nBytes and copyToMem disagree" << endl;
+        return -20;
+      }
+      size_t offset = Box::linearSize() + ebg.getEBCellFlagFab().nBytes(grid, 0, 1);
+      int regIrregCovCode = *((int*) &buf[offset]);
+      offset += sizeof(int);
+      if(regIrregCovCode == 0)
+      {
+        vector<unsigned char> nodebuf;
+        for(BoxIterator bit(grid); bit.ok(); ++bit)
+        {
+          GraphNode node;
+          node.linearIn(&buf[offset]);
+          size_t nodeSize = node.linearSize();
+          nodebuf.resize(nodeSize);
+          node.linearOut(nodebuf.data());
+          if((offset + nodeSize > nbytes) ||
+             (std::memcmp(nodebuf.data(), &buf[offset], nodeSize) != 0))
+          {
+            amrex::Print() << "checkgraphbytes: GraphNode bytes differ at " << bit() << endl;
+            return -21;
+          }
+          offset += nodeSize;
+        }
+      }
+      if(offset != nbytes)
+      {
+        amrex::Print() << "checkgraphbytes: graph size mismatch" << endl;
+        return -22;
+      }
+    }
+    return 0;
+  }
+  /****/
   int checkData(  const FabArray<EBData> & a_ebd1,
                   const FabArray<EBData> & a_ebd2,
                   const EBLevelGrid      & a_eblg)
@@ -470,10 +531,84 @@ donotcallpls()
         amrex::Print() << "data mismatch" << endl;
         return retdata;
       }
+      int retbytes = checkGraphBytes(*ebislOut.getAllGraphs(), eblgIn[ilev]);
+      if(retbytes != 0)
+      {
+        amrex::Print() << "graph bytes mismatch" << endl;
+        return retbytes;
+      }
     }
 
     return 0;
   }
+  /***************/
+  //define through the geometry cache twice.  the first define generates
+  //and writes the cache, the second one has to read it back.
+  int testEBCache(int igeom)
+  {
+    ParmParse ppebis("ebis");
+    ppebis.add("cache_dir", string("ebcache.plt"));
+    UtilCreateDirectoryDestructive("ebcache.plt", true);
+
+    Box domain;
+    Real dx;
+    makeGeometry(domain, dx, igeom);
+    EBIndexSpace* ebisPtr = AMReX_EBIS::instance();
+    int numLevelsIn = ebisPtr->getNumLevels();
+    vector<Box> domainsIn = ebisPtr->getDomains();
+    int nCellMaxIn = ebisPtr->getNCellMax();
+    vector<EBLevelGrid> eblgIn(numLevelsIn);
+    for(int ilev = 0; ilev < numLevelsIn; ilev++)
+    {
+      BoxArray ba(domainsIn[ilev]);
+      ba.maxSize(nCellMaxIn);
+      DistributionMapping dm(ba);
+      eblgIn[ilev]= EBLevelGrid(ba, dm, domainsIn[ilev], 2);
+    }
+    ebisPtr->clear();
+    if(!amrex::FileExists("ebcache.plt/cachekey"))
+    {
+      amrex::Print() << "cache: no cache written" << endl;
+      return -10;
+    }
+
+    //the generation cost is all in the first define
+    Real t0 = ParallelDescriptor::second();
+    makeGeometry(domain, dx, igeom);
+    Real tread = ParallelDescriptor::second() - t0;
+    amrex::Print() << "define from cache took " << tread << " s" << endl;
+
+    if(ebisPtr->getNumLevels() != numLevelsIn)
+    {
+      amrex::Print() << "cache: num levels mismatch" << endl;
+      return -11;
+    }
+    for(int ilev = 0; ilev < numLevelsIn; ilev++)
+    {
+      if(ebisPtr->getDomains()[ilev] != domainsIn[ilev])
+      {
+        amrex::Print() << "cache: domains mismatch" << endl;
+        return -12;
+      }
+      EBLevelGrid eblgOut(eblgIn[ilev].getDBL(), eblgIn[ilev].getDM(), domainsIn[ilev], 2);
+      EBISLayout ebislIn  = eblgIn[ilev].getEBISL();
+      EBISLayout ebislOut = eblgOut.getEBISL();
+      int retgraph = checkGraphs(*ebislIn.getAllGraphs(), *ebislOut.getAllGraphs(), eblgIn[ilev]);
+      if(retgraph != 0)
+      {
+        amrex::Print() << "cache: graph mismatch" << endl;
+        return retgraph;
+      }
+      int retdata  = checkData(  *ebislIn.getAllData  (), *ebislOut.getAllData  (), eblgIn[ilev]);
+      if(retdata != 0)
+      {
+        amrex::Print() << "cache: data mismatch" << endl;
+        return retdata;
+      }
+    }
+    ppebis.add("cache_dir", string(""));
+    return 0;
+  }
 }
 /***************/
 int
@@ -489,6 +624,23 @@ main(int argc, char* argv[])
     {
       amrex::Print() << "EBIndexSpace I/O test failed with code " << retval << "\n";
     }
+    retval = amrex::testEBCache(igeom);
+    if(retval != 0)
+    {
+      amrex::Print() << "EBIndexSpace cache test failed with code " << retval << "\n";
+    }
+  }
+  {
+    //the cache key of an stl geometry comes from the file
+    amrex::ParmParse pp;
+    if(pp.contains("stl_file"))
+    {
+      retval = amrex::testEBCache(2);
+      if(retval != 0)
+      {
+        amrex::Print() << "EBIndexSpace stl cache test failed with code " << retval << "\n";
+      }
+    }
   }
   amrex::Print() << "EBIndexSpace I/O test passed \n";
 
@@ -0,0 +1,226 @@
+/*
+ *      .o.       ooo        ooooo ooooooooo.             ooooooo  ooooo
+ *     .888.      `88.       .888' `888   `Y88.            `8888    d8'
+ *    .8"888.      888b     d'888   888   .d88'  .ooooo.     Y888..8P
+ *   .8' `888.     8 Y88. .P  888   888ooo88P'  d88' `88b     `8888'
+ *  .88ooo8888.    8  `888'   888   888`88b.    888ooo888    .8PY888.
+ * .8'     `888.   8    Y     888   888  `88b.  888    .o   d8'  `888b
+ *o88o     o8888o o8o        o888o o888o  o888o `Y8bod8P' o888o  o88888o
+ *
+ */
+
+#include <cmath>
+
+#include "AMReX_GeometryShop.H"
+#include "AMReX_EBIndexSpace.H"
+#include "AMReX_EBISLayout.H"
+#include "AMReX_EBLevelGrid.H"
+#include "AMReX_EBCellFactory.H"
+#include "AMReX_EBCellFAB.H"
+#include "AMReX_VoFIterator.H"
+#include "AMReX_ParmParse.H"
+#include "AMReX_RealVect.H"
+#include "AMReX_SphereIF.H"
+#include "AMReX_AggStencil.H"
+#include "AMReX_Stencils.H"
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Utility.H>
+#include <AMReX_Print.H>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//micro-benchmark for AggStencil::apply against the pointwise stencil loop
+using namespace amrex;
+using std::cout;
+using std::endl;
+
+////////////
+//kappa*div(grad phi) with no centroid interpolation and neumann domain bcs.
+//irregular cells end up with stencils of different sizes.
+void getStencil(VoFStencil     & a_stencil,
+                const VolIndex & a_vof,
+                const EBISBox  & a_ebisBox,
+                const Real     & a_dx)
+{
+  a_stencil.clear();
+  Real dxinvsq = 1.0/a_dx/a_dx;
+  for (int idir = 0; idir < SpaceDim; idir++)
+  {
+    for (SideIterator sit; sit.ok(); ++sit)
+    {
+      Vector<FaceIndex> faces = a_ebisBox.getFaces(a_vof, idir, sit());
+      for (int iface = 0; iface < faces.size(); iface++)
+      {
+        const FaceIndex& face = faces[iface];
+        if (!face.isBoundary())
+        {
+          Real weight = a_ebisBox.areaFrac(face)*dxinvsq;
+          a_stencil.add(face.getVoF(flip(sit())), weight);
+          a_stencil.add(a_vof, -weight);
+        }
+      }
+    }
+  }
+}
+////////////
+int testStuff()
+{
+  int eekflag =  0;
+  Real radius = 0.5;
+  Real domlen = 1;
+  std::vector<Real> centervec(SpaceDim);
+  std::vector<int>  ncellsvec(SpaceDim);
+  int maxboxsize = 64;
+  int numApply = 100;
+  bool irregOnly = true;
+
+  ParmParse pp;
+  pp.getarr(  "n_cell"       , ncellsvec, 0, SpaceDim);
+  pp.get(   "sphere_radius", radius);
+  pp.getarr("sphere_center", centervec, 0, SpaceDim);
+  pp.get("domain_length", domlen);
+  pp.query("maxboxsize", maxboxsize);
+  pp.query("num_apply", numApply);
+  pp.query("irregular_only", irregOnly);
+
+  IntVect ivlo = IntVect::TheZeroVector();
+  IntVect ivhi;
+  RealVect center;
+  for(int idir = 0; idir < SpaceDim; idir++)
+  {
+    ivhi[idir] = ncellsvec[idir] - 1;
+    center[idir] = centervec[idir];
+  }
+  Box domain(ivlo, ivhi);
+  Real dx = domlen/ncellsvec[0];
+
+  amrex::Print() << "Define geometry\n";
+  BL_PROFILE_VAR("define_geometry",dg);
+  bool insideRegular = false;
+  SphereIF sphere(radius, center, insideRegular);
+  GeometryShop gshop(sphere);
+  AMReX_EBIS::instance()->define(domain, RealVect::Zero, dx, gshop, maxboxsize);
+  BL_PROFILE_VAR_STOP(dg);
+
+  BoxArray ba(domain);
+  ba.maxSize(maxboxsize);
+  DistributionMapping dm(ba);
+  EBLevelGrid eblg(ba, dm, domain, 2);
+  EBCellFactory fact(eblg.getEBISL());
+  FabArray<EBCellFAB> phi(ba, dm, 1, 1, MFInfo(), fact);
+  FabArray<EBCellFAB> lphAgg(ba, dm, 1, 0, MFInfo(), fact);
+
+  Real tbuild = 0;
+  Real tpoint = 0;
+  Real tagg   = 0;
+  long numvofs = 0;
+  Real maxDiff = 0;
+  for(MFIter mfi(phi); mfi.isValid(); ++mfi)
+  {
+    const Box& grid = ba[mfi];
+    const EBISBox& ebisBox = eblg.getEBISL()[mfi];
+
+    //something smooth but not trivial for the source
+    phi[mfi].setVal(0.);
+    for(VoFIterator vofit(IntVectSet(phi[mfi].box()), ebisBox.getEBGraph()); vofit.ok(); ++vofit)
+    {
+      const IntVect& iv = vofit().gridIndex();
+      Real val = 1;
+      for(int idir = 0; idir < SpaceDim; idir++)
+      {
+        val *= std::sin((iv[idir]+0.5)*dx*(idir+1));
+      }
+      phi[mfi](vofit(), 0) = val;
+    }
+    lphAgg[mfi].setVal(0.);
+
+    IntVectSet ivs = irregOnly ? ebisBox.getIrregIVS(grid) : IntVectSet(grid);
+    VoFIterator vofit(ivs, ebisBox.getEBGraph());
+    const Vector<VolIndex>& vofs = vofit.getVector();
+    Vector<VoFStencil> stencils(vofs.size());
+    Vector<std::shared_ptr<BaseIndex  > > dstVoFs(vofs.size());
+    Vector<std::shared_ptr<BaseStencil> > vofStencils(vofs.size());
+    for(int ivof = 0; ivof < vofs.size(); ivof++)
+    {
+      getStencil(stencils[ivof], vofs[ivof], ebisBox, dx);
+      dstVoFs[ivof]     = std::shared_ptr<BaseIndex  >(new VolIndex(vofs[ivof]));
+      vofStencils[ivof] = std::shared_ptr<BaseStencil>(new VoFStencil(stencils[ivof]));
+    }
+    numvofs += vofs.size();
+
+    Real t0 = amrex::second();
+    AggStencil<EBCellFAB, EBCellFAB> sten(dstVoFs, vofStencils, phi[mfi], lphAgg[mfi]);
+    tbuild += amrex::second() - t0;
+
+    Vector<Real> pointVal(vofs.size());
+    t0 = amrex::second();
+    for(int irep = 0; irep < numApply; irep++)
+    {
+      for(int ivof = 0; ivof < vofs.size(); ivof++)
+      {
+        pointVal[ivof] = applyVoFStencil(stencils[ivof], phi[mfi]);
+      }
+    }
+    tpoint += amrex::second() - t0;
+
+    t0 = amrex::second();
+    for(int irep = 0; irep < numApply; irep++)
+    {
+      sten.apply(lphAgg[mfi], phi[mfi], 0, false);
+    }
+    tagg += amrex::second() - t0;
+
+    for(int ivof = 0; ivof < vofs.size(); ivof++)
+    {
+      maxDiff = std::max(maxDiff, std::abs(lphAgg[mfi](vofs[ivof], 0) - pointVal[ivof]));
+    }
+  }
+
+  int nthreads = 1;
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads();
+#endif
+  amrex::Print() << "aggsten benchmark: " << numvofs << " vofs, "
+                 << numApply << " applications, " << nthreads << " threads\n";
+  amrex::Print() << "  aggsten build         = " << tbuild << " s\n";
+  amrex::Print() << "  pointwise apply       = " << tpoint << " s\n";
+  amrex::Print() << "  aggsten apply         = " << tagg   << " s\n";
+  if(tagg > 0)
+  {
+    amrex::Print() << "  speedup               = " << tpoint/tagg << "\n";
+  }
+  amrex::Print() << "  max |agg - pointwise| = " << maxDiff << "\n";
+  if(maxDiff > 1.0e-10)
+  {
+    amrex::Print() << "aggsten and pointwise apply disagree\n";
+    eekflag = 1;
+  }
+  return eekflag;
+}
+
+
+int
+main(int argc,char **argv)
+{
+  amrex::Initialize(argc,argv);
+  {
+    BL_PROFILE_VAR("main()", pmain);
+
+    int eekflag = testStuff();
+
+    if (eekflag != 0)
+    {
+      cout << "non zero eek detected = " << eekflag << endl;
+      cout << "aggsten benchmark failed" << endl;
+    }
+    else
+    {
+      cout << "aggsten benchmark passed" << endl;
+    }
+
+    BL_PROFILE_VAR_STOP(pmain);
+  }
+  amrex::Finalize();
+  return 0;
+}
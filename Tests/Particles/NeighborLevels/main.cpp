@@ -0,0 +1,228 @@
+//
+// Checks the neighbor lists of NeighborParticleContainer on a three-level
+// hierarchy against a brute-force search over all particles, with and
+// without periodicity and tiling.  The first steps use fillNeighbors and
+// buildNeighborList, the later ones the Verlet lists.  Every pair closer
+// than the cutoff must be found, on every level and across the coarse/fine
+// boundaries.
+//
+
+#include <cmath>
+#include <random>
+#include <set>
+
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_NeighborParticles.H>
+
+using namespace amrex;
+
+namespace
+{
+    const int  n      = 16;
+    const Real cutoff = 0.45;
+    const Real skin   = 0.04;
+    const int  np     = 4000;
+}
+
+class TestContainer
+    : public NeighborParticleContainer<AMREX_SPACEDIM, 0>
+{
+public:
+
+    TestContainer (ParGDBBase* gdb, int ncells)
+        : NeighborParticleContainer<AMREX_SPACEDIM, 0>(gdb, ncells) {}
+
+protected:
+
+    virtual bool check_pair (const ParticleType& p, const ParticleType& q) override
+    {
+        Real d2 = 0.0;
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            const Real x = p.pos(d) - q.pos(d);
+            d2 += x*x;
+        }
+        return d2 <= cutoff*cutoff;
+    }
+};
+
+using PType = TestContainer::ParticleType;
+
+int
+runTest (int periodic, bool tiling)
+{
+    TestContainer::do_tiling = tiling;
+    TestContainer::tile_size = IntVect(AMREX_D_DECL(4,4,4));
+
+    RealBox rb;
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+        rb.setLo(d, 0.0);
+        rb.setHi(d, n);
+    }
+    int is_per[AMREX_SPACEDIM];
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) is_per[d] = periodic;
+
+    const Box dom0(IntVect::TheZeroVector(), IntVect(AMREX_D_DECL(n-1,n-1,n-1)));
+    const Box grids[3] = { dom0,
+                           Box(IntVect(AMREX_D_DECL( 8, 8, 8)), IntVect(AMREX_D_DECL(23,23,23))),
+                           Box(IntVect(AMREX_D_DECL(24,24,28)), IntVect(AMREX_D_DECL(43,39,43))) };
+
+    Vector<Geometry> geom(3);
+    Vector<BoxArray> ba(3);
+    Vector<DistributionMapping> dm(3);
+    for (int lev = 0; lev < 3; ++lev) {
+        Box dom = dom0;
+        dom.refine(1 << lev);
+        geom[lev].define(dom, &rb, 0, is_per);
+        ba[lev] = BoxArray(grids[lev]);
+        ba[lev].maxSize(8);
+        dm[lev].define(ba[lev]);
+    }
+    Vector<int> rr(2, 2);
+    ParGDB gdb(geom, dm, ba, rr);
+
+    TestContainer pc(&gdb, 2);
+
+    // Random positions and velocities, ids 1 .. np.
+    std::mt19937 mt(7);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    PType::NextID(1L);
+    auto& tile = pc.GetParticles(0)[std::make_pair(0, 0)];
+    for (int k = 0; k < np; ++k) {
+        PType p;
+        p.id()  = PType::NextID();
+        p.cpu() = ParallelDescriptor::MyProc();
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            p.pos(d)   = n*u(mt);
+            p.rdata(d) = 0.5*(2*u(mt)-1);
+        }
+        if (ParallelDescriptor::IOProcessor()) tile.push_back(p);
+    }
+    pc.Redistribute();
+    pc.setVerletSkin(cutoff, skin);
+
+    int nbad = 0;
+    for (int step = 0; step < 12; ++step)
+    {
+        const bool verlet = step >= 4;
+        if (verlet) {
+            pc.updateVerletLists(true);
+        } else {
+            pc.Redistribute();
+            for (int lev = 0; lev < 3; ++lev) {
+                pc.fillNeighbors(lev);
+                pc.buildNeighborList(lev);
+            }
+        }
+
+        // All positions, by id, on every process.
+        Vector<Real> pos(np*AMREX_SPACEDIM, 0.0);
+        for (int lev = 0; lev < 3; ++lev) {
+            for (TestContainer::MyParIter pti(pc, lev); pti.isValid(); ++pti) {
+                for (const auto& p : pti.GetArrayOfStructs()()) {
+                    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                        pos[(p.id()-1)*AMREX_SPACEDIM+d] = p.pos(d);
+                    }
+                }
+            }
+        }
+        ParallelDescriptor::ReduceRealSum(pos.dataPtr(), pos.size());
+
+        std::set<std::pair<int,int> > ref, got;
+        for (int lev = 0; lev < 3; ++lev)
+        {
+            for (TestContainer::MyParIter pti(pc, lev); pti.isValid(); ++pti)
+            {
+                TestContainer::PairIndex index(pti.index(), pti.LocalTileIndex());
+                const auto& ps = pti.GetArrayOfStructs()();
+                const int Np = ps.size();
+                const PType* nbrs = (const PType*) pc.getNeighbors(lev)[index].dataPtr();
+                auto get = [&] (int j) -> const PType& { return (j < Np) ? ps[j] : nbrs[j-Np]; };
+
+                for (const auto& p : ps) {
+                    for (int j = 1; j <= np; ++j) {
+                        if (j == p.id()) continue;
+                        Real d2 = 0.0;
+                        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                            Real x = p.pos(d) - pos[(j-1)*AMREX_SPACEDIM+d];
+                            if (periodic) x -= n*std::round(x/n);
+                            d2 += x*x;
+                        }
+                        if (d2 <= cutoff*cutoff) ref.insert({p.id(), j});
+                    }
+                }
+
+                if (verlet) {
+                    const auto& offsets = pc.getVerletOffsets(lev)[index];
+                    const auto& nl      = pc.getVerletList(lev)[index];
+                    for (int i = 0; i < Np; ++i) {
+                        for (int k = offsets[i]; k < offsets[i+1]; ++k) {
+                            const PType& q = get(nl[k]);
+                            Real d2 = 0.0;
+                            for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                                const Real x = ps[i].pos(d) - q.pos(d);
+                                d2 += x*x;
+                            }
+                            if (d2 <= cutoff*cutoff) got.insert({ps[i].id(), q.id()});
+                        }
+                    }
+                } else {
+                    const auto& nl = pc.getNeighborList(lev)[index];
+                    int i = 0;
+                    for (int s = 0; s < static_cast<int>(nl.size()); s += nl[s] + 1, ++i) {
+                        for (int k = 1; k <= nl[s]; ++k) {
+                            got.insert({ps[i].id(), get(nl[s+k]-1).id()});
+                        }
+                    }
+                }
+            }
+        }
+
+        if (ref != got) {
+            ++nbad;
+            amrex::AllPrint() << "periodic " << periodic << " tiling " << tiling
+                              << " step " << step << ": " << ref.size()
+                              << " pairs, found " << got.size() << "\n";
+        }
+
+        // Move the particles, reflecting them at the walls if not periodic.
+        for (int lev = 0; lev < 3; ++lev) {
+            for (TestContainer::MyParIter pti(pc, lev); pti.isValid(); ++pti) {
+                for (auto& p : pti.GetArrayOfStructs()()) {
+                    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                        p.pos(d) += 0.02*p.rdata(d);
+                        if (!periodic) {
+                            if (p.pos(d) < 0) { p.pos(d) = -p.pos(d);     p.rdata(d) *= -1; }
+                            if (p.pos(d) > n) { p.pos(d) = 2*n-p.pos(d);  p.rdata(d) *= -1; }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // The periodicity is static in Geometry; reset it for the next case.
+    Geometry::Finalize();
+
+    return nbad;
+}
+
+int
+main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int fails = 0;
+        for (int periodic = 0; periodic < 2; ++periodic) {
+            for (int tiling = 0; tiling < 2; ++tiling) {
+                fails += runTest(periodic, tiling);
+            }
+        }
+        ParallelDescriptor::ReduceIntSum(fails);
+        amrex::Print() << "mismatching steps " << fails << "\n";
+        if (fails > 0) {
+            amrex::Abort("NeighborLevels: neighbor lists differ from the brute-force search");
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,114 @@
+//
+// Checks the particle ids handed out by Particle::AssignNextID:
+//
+//  - ids assigned by many OpenMP threads at once are unique,
+//  - they stay unique and valid when the per-process counter runs past
+//    LastParticleID and the high part goes into the cpu slot,
+//  - globalID() is nonnegative and decodes back to the birth process and
+//    the counter, also for the largest birth process the layout allows.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_Particles.H>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace amrex;
+
+typedef Particle<1,0> PType;
+
+namespace
+{
+    // Assign n ids from inside a parallel region and return their global ids.
+    Vector<std::int64_t>
+    assignIDs (int n, int& nbad)
+    {
+        Vector<std::int64_t> gids(n);
+        int bad = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:bad)
+#endif
+        for (int i = 0; i < n; ++i)
+        {
+            PType p;
+            PType::AssignNextID(p);
+            if (p.id() <= 0 || p.id() > LastParticleID) ++bad;
+            if (p.birthCPU() != ParallelDescriptor::MyProc()) ++bad;
+            if (p.globalID() < 0) ++bad;
+            gids[i] = p.globalID();
+        }
+        nbad += bad;
+        return gids;
+    }
+
+    int
+    countDuplicates (Vector<std::int64_t> v)
+    {
+        std::sort(v.begin(), v.end());
+        return v.size() - (std::unique(v.begin(), v.end()) - v.begin());
+    }
+}
+
+int
+main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int fails = 0;
+        const int n = 100000;
+
+        // Many threads at once.
+        PType::NextID(1L);
+        Vector<std::int64_t> gids = assignIDs(n, fails);
+        fails += countDuplicates(gids);
+
+        // Across the end of the id slot: these land in epochs 0 and 1.
+        const long start = LastParticleID - n/2;
+        PType::NextID(start);
+        Vector<std::int64_t> rollover = assignIDs(n, fails);
+        fails += countDuplicates(rollover);
+        const std::int64_t lo = (static_cast<std::int64_t>(ParallelDescriptor::MyProc())
+                                 << ParticleCounterBits) + start;
+        for (std::int64_t g : rollover) {
+            // The ids handed out are within [start, MaxNextID()) of the counter.
+            if (g < lo || g >= lo + (PType::MaxNextID() - start)) ++fails;
+        }
+
+        // In order outside of parallel regions, and the epoch moves into cpu.
+        PType::NextID(static_cast<long>(LastParticleID));
+        PType a, b;
+        PType::AssignNextID(a);
+        PType::AssignNextID(b);
+        if (a.id() != LastParticleID || b.id() != 1) ++fails;
+        if (a.cpu() != ParallelDescriptor::MyProc()) ++fails;
+        if (b.cpu() == ParallelDescriptor::MyProc()) ++fails;
+        if (b.birthCPU() != ParallelDescriptor::MyProc()) ++fails;
+        if (b.globalID() != a.globalID() + 1) ++fails;
+
+        // The largest birth process and epoch the layout allows.
+        PType c;
+        c.id()  = LastParticleID;
+        c.cpu() = ParticleCPUMask | ((ParticleIDEpochs-1) << ParticleCPUBits);
+        const std::int64_t gc = c.globalID();
+        if (gc < 0) ++fails;
+        if ((gc >> ParticleCounterBits) != ParticleCPUMask) ++fails;
+        if ((gc & ((std::int64_t(1) << ParticleCounterBits) - 1))
+            != std::int64_t(ParticleIDEpochs)*LastParticleID) ++fails;
+
+        PType::NextID(1L);
+
+        ParallelDescriptor::ReduceIntSum(fails);
+        amrex::Print() << "fails " << fails << "\n";
+        if (fails > 0) {
+            amrex::Abort("ParticleIDs: duplicate or invalid particle ids");
+        }
+    }
+    amrex::Finalize();
+}
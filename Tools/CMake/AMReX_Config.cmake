@@ -80,6 +80,13 @@ else ()
    endif ()
 endif()
 
+#
+# Setup threads: the in situ AMR diagnostics write their output from a
+# background thread
+#
+find_package (Threads REQUIRED)
+append_to_link_line ( CMAKE_THREAD_LIBS_INIT AMREX_EXTRA_CXX_LINK_LINE )
+
 #
 # Setup third-party profilers
 #
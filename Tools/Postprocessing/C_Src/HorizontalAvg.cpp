@@ -28,6 +28,9 @@ main (int   argc,
     int verbose; pp.query("verbose",verbose);
     if (verbose > 2)
         AmrData::SetVerbose(true);
+
+    bool use_mmap = false; pp.query("use_mmap",use_mmap);
+    AmrData::SetUseMMap(use_mmap);
     
     std::string infile; pp.get("infile",infile);
     std::string outdir = infile + std::string("_stats"); pp.query("outdir",outdir);
@@ -94,7 +97,14 @@ main (int   argc,
     BoxArray ba = BoxArray(domain).maxSize(max_grid_size);
     DistributionMapping dmap(ba);
     MultiFab mf(ba,dmap,nComp,0);
-    amrData.FillVar(mf,finestLevel,varNames,destFillComps);
+
+    // If the level covers the domain, read just the parts of the fabs we own,
+    // through mmap with use_mmap=1.  Otherwise fill from the coarser levels.
+    if (amrData.boxArray(finestLevel).contains(domain)) {
+        amrData.ReadRegion(mf,finestLevel,varNames,destFillComps);
+    } else {
+        amrData.FillVar(mf,finestLevel,varNames,destFillComps);
+    }
 
     if (ParallelDescriptor::IOProcessor() && verbose)
         std::cerr << "Data has been read" << std::endl;
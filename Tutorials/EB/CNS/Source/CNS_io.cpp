@@ -209,17 +209,13 @@ CNS::writePlotFile (const std::string& dir, std::ostream& os, VisMF::How how)
 	cnt++;
     }
     //
-    // Cull data from derived variables.
+    // Derived data -- one FillPatch per state type for all of them.
     //
     if (derive_names.size() > 0)
     {
-	for (std::list<std::string>::iterator it = derive_names.begin();
-	     it != derive_names.end(); ++it)
-	{
-            auto derive_dat = derive(*it,cur_time,nGrow);
-            MultiFab::Copy(plotMF,*derive_dat,0,cnt,1,nGrow);
-	    cnt++;
-	}
+        derive(Vector<std::string>(derive_names.begin(), derive_names.end()),
+               cur_time,plotMF,cnt);
+        cnt += num_derive;
     }
 
     plotMF.setVal(0.0, cnt, 1, nGrow);
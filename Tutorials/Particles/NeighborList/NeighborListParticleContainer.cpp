@@ -108,6 +108,30 @@ void NeighborListParticleContainer::computeForcesNL() {
     }
 }
 
+void NeighborListParticleContainer::computeForcesVerlet() {
+
+    BL_PROFILE("NeighborListParticleContainer::computeForcesVerlet");
+
+    const int lev = 0;
+
+    updateVerletList(lev);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MyParIter pti(*this, lev, MFItInfo().SetDynamic(false)); pti.isValid(); ++pti) {
+        PairIndex index(pti.index(), pti.LocalTileIndex());
+        AoS& particles = pti.GetArrayOfStructs();
+        int Np = particles.size();
+        int Nn = neighbors[index].size() / pdata_size;
+        amrex_compute_forces_verlet(particles.data(), &Np, 
+                                    neighbors[index].dataPtr(), &Nn,
+                                    verlet_offsets[index].dataPtr(),
+                                    verlet_list[index].dataPtr(),
+                                    &cutoff, &min_r);
+    }
+}
+
 void NeighborListParticleContainer::moveParticles(const Real dt) {
 
     BL_PROFILE("NeighborListParticleContainer::moveParticles");
@@ -22,6 +22,10 @@ int main(int argc, char* argv[])
     pp.get("dt", dt);
     pp.get("do_nl", do_nl);
 
+    // a positive skin switches to Verlet lists
+    Real verlet_skin = 0.0;
+    pp.query("verlet_skin", verlet_skin);
+
     RealBox real_box;
     for (int n = 0; n < BL_SPACEDIM; n++) {
         real_box.setLo(n, 0.0);
@@ -49,8 +53,16 @@ int main(int argc, char* argv[])
 
     const int lev = 0;
 
+    if (verlet_skin > 0.0) myPC.useVerletList(verlet_skin);
+
     for (int i = 0; i < max_step; i++) {
         if (write_particles) myPC.writeParticles(i);
+
+        if (verlet_skin > 0.0) {
+            myPC.computeForcesVerlet();
+            myPC.moveParticles(dt);
+            continue;
+        }
         
         myPC.fillNeighbors(lev);
 
@@ -64,6 +76,7 @@ int main(int argc, char* argv[])
         myPC.Redistribute();
     }
 
+    if (verlet_skin > 0.0) myPC.Redistribute();
     if (write_particles) myPC.writeParticles(max_step);
     
     amrex::Finalize();
@@ -203,3 +203,62 @@
     neighbors(:)  = particles(np+1:)
 
   end subroutine amrex_compute_forces_nl
+
+  subroutine amrex_compute_forces_verlet(particles, np, neighbors, nn, &
+                                         offsets, nl, cutoff, min_r) &
+       bind(c,name='amrex_compute_forces_verlet')
+
+    use iso_c_binding
+    use amrex_fort_module,           only : amrex_real
+    use short_range_particle_module, only : particle_t
+
+    integer,          intent(in   ) :: np, nn
+    real(amrex_real), intent(in   ) :: cutoff, min_r
+    type(particle_t), intent(inout) :: particles(np)
+    type(particle_t), intent(in   ) :: neighbors(nn)
+    integer,          intent(in   ) :: offsets(np+1)
+    integer,          intent(in   ) :: nl(*)
+
+    real(amrex_real) dx, dy, r2, r, coef, mass
+    real(amrex_real) pos(2)
+    integer i, j, k
+
+    mass   = 1.d-2
+
+!   offsets and nl hold 0-based indices into particles followed by neighbors
+    do i = 1, np
+
+!      zero out the particle acceleration
+       particles(i)%acc(1) = 0.d0
+       particles(i)%acc(2) = 0.d0
+
+       do k = offsets(i) + 1, offsets(i+1)
+
+          j = nl(k) + 1
+          if (j .le. np) then
+             pos = particles(j)%pos
+          else
+             pos = neighbors(j-np)%pos
+          end if
+
+          dx = particles(i)%pos(1) - pos(1)
+          dy = particles(i)%pos(2) - pos(2)
+
+          r2 = dx * dx + dy * dy
+
+          if (r2 .gt. cutoff*cutoff) then
+             cycle
+          end if
+
+          r2 = max(r2, min_r*min_r) 
+          r = sqrt(r2)
+
+          coef = (1.d0 - cutoff / r) / r2 / mass
+          particles(i)%acc(1) = particles(i)%acc(1) + coef * dx
+          particles(i)%acc(2) = particles(i)%acc(2) + coef * dy
+
+       end do
+
+    end do
+
+  end subroutine amrex_compute_forces_verlet